@@ -1,5 +1,7 @@
 #include "app.h"
 #include "file_browser.h"
+#include "memory_governor.h"
+#include "mupdf_context_pool.h"
 #include "options_manager.h"
 #include "path_utils.h"
 #include "renderer.h"
@@ -187,6 +189,12 @@ int main(int argc, char* argv[])
         {
             // Clear document path to force browser to show on next iteration
             std::cout << "Main: Browse mode active, returning to file browser" << std::endl;
+
+            // Both should stay flat from one book to the next
+            MuPdfContextPool::Stats pool = MuPdfContextPool::shared().getStats();
+            std::cout << "Main: MuPDF contexts created=" << pool.created << " reused=" << pool.reused
+                      << " idle=" << pool.idle << ", RSS " << (MemoryGovernor::residentBytes() >> 10) << " KB" << std::endl;
+            MuPdfContextPool::shared().logAllocatorStats();
             documentPath.clear();
         }
     }
@@ -116,10 +116,16 @@ private:
 
     // Font management
     void applyPendingFontChange(); // Apply deferred font configuration changes safely
+    void finishPendingRelayout();  // Switch to a background relayout once it is ready
 
     // State Management
     void printAppState();
 
+    // Hand the document's caches to the MemoryGovernor
+    void registerMemoryConsumers();
+    void unregisterMemoryConsumers();
+    std::vector<int> m_memoryConsumerIds;
+
     // Font management
     void toggleFontMenu();
     void applyFontConfiguration(const FontConfig& config);
@@ -0,0 +1,122 @@
+#ifndef DISK_PAGE_CACHE_H
+#define DISK_PAGE_CACHE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Persistent cache of rendered ARGB pages in the reader state directory.
+ *
+ * Each page is one zlib-compressed file named after a hash of its key. The key
+ * combines the document identity (path, size and modification time) with the
+ * render settings that change the pixels, so editing a file or changing the
+ * theme simply stops matching the old entries. The directory is trimmed to a
+ * byte budget, least recently used first; file modification times carry the
+ * recency across sessions.
+ * Writes usually go through storeAsync(), which compresses on a writer thread
+ * owned by the cache so they outlive the document that queued them.
+ * All methods are thread-safe.
+ */
+class DiskPageCache
+{
+public:
+    struct Key
+    {
+        std::string document; // documentIdentity() of the source file
+        std::string variant;  // Render settings that affect the pixels
+        int page = 0;
+        int scale = 0;
+    };
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writes = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t budgetBytes = 0;
+    };
+
+    using PixelBufferPtr = std::shared_ptr<const std::vector<uint32_t>>;
+
+    explicit DiskPageCache(std::filesystem::path directory, uint64_t budgetBytes = defaultBudgetBytes());
+    ~DiskPageCache(); // Finishes queued writes
+
+    DiskPageCache(const DiskPageCache&) = delete;
+    DiskPageCache& operator=(const DiskPageCache&) = delete;
+
+    // Per-platform default budget
+    static uint64_t defaultBudgetBytes();
+
+    // "path|size|mtime" for a file, or an empty string if it cannot be stat'ed
+    static std::string documentIdentity(const std::string& path);
+
+    // Read a page back. Misses are answered from the in-memory index without IO.
+    bool load(const Key& key, std::vector<uint32_t>& pixels, int& width, int& height);
+
+    // Compress and write a page (width * height pixels), then trim to the budget
+    void store(const Key& key, const uint32_t* pixels, int width, int height);
+
+    // Queue store() on the writer thread. A newer write for the same key
+    // replaces a queued one; past MAX_PENDING_WRITES the oldest is dropped.
+    void storeAsync(const Key& key, PixelBufferPtr pixels, int width, int height);
+
+    bool contains(const Key& key);
+
+    Stats getStats() const;
+
+private:
+    static constexpr size_t MAX_PENDING_WRITES = 8;
+
+    struct PendingWrite
+    {
+        Key key;
+        PixelBufferPtr pixels;
+        int width = 0;
+        int height = 0;
+    };
+
+    struct IndexEntry
+    {
+        uint64_t bytes = 0;
+        uint64_t lastUse = 0;
+    };
+
+    static std::string keyText(const Key& key);
+    static std::string fileNameFor(const std::string& text);
+    void ensureIndexLocked();
+    void trimLocked(const std::string& keep);
+    void removeLocked(std::map<std::string, IndexEntry>::iterator it);
+    void writerLoop();
+
+    std::filesystem::path m_directory;
+    mutable std::mutex m_mutex;
+    std::map<std::string, IndexEntry> m_index; // File name -> size and recency
+    bool m_indexLoaded = false;
+    uint64_t m_useCounter = 0;
+    uint64_t m_bytes = 0;
+    uint64_t m_budgetBytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_writes = 0;
+    uint64_t m_evictions = 0;
+
+    std::mutex m_writeMutex;
+    std::condition_variable m_writeCv;
+    std::deque<PendingWrite> m_pendingWrites;
+    std::thread m_writer;
+    bool m_stopWriter = false;
+};
+
+#endif // DISK_PAGE_CACHE_H
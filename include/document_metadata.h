@@ -0,0 +1,45 @@
+#ifndef DOCUMENT_METADATA_H
+#define DOCUMENT_METADATA_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Layout facts about a document that are expensive to recompute on open.
+ *
+ * Persisted as a small binary sidecar in the reader state directory, keyed by
+ * the document identity (path, size and modification time) together with the
+ * user CSS, since the CSS changes how reflowable books paginate.
+ */
+struct DocumentMetadata
+{
+    struct PageBounds
+    {
+        float x0 = 0.0f;
+        float y0 = 0.0f;
+        float x1 = 0.0f;
+        float y1 = 0.0f;
+
+        bool known() const
+        {
+            return x1 > x0 && y1 > y0;
+        }
+    };
+
+    int pageCount = 0;              // 0 if the exact count was never determined
+    std::vector<PageBounds> bounds; // Native page bounds, indexed by page
+};
+
+// Read the sidecar for a document. Returns false if there is none or it does not match.
+bool loadDocumentMetadata(const std::string& documentIdentity, const std::string& css, DocumentMetadata& metadata);
+
+// Write (replace) the sidecar for a document
+bool saveDocumentMetadata(const std::string& documentIdentity, const std::string& css,
+                          const DocumentMetadata& metadata);
+
+// Where MuPDF's layout accelerator for a document is kept, next to its sidecar.
+// The file is written by fz_save_accelerator, so the key lives only in the name.
+std::filesystem::path documentAcceleratorPath(const std::string& documentIdentity, const std::string& css);
+
+#endif // DOCUMENT_METADATA_H
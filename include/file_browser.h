@@ -1,6 +1,7 @@
 #ifndef FILE_BROWSER_H
 #define FILE_BROWSER_H
 
+#include "pixel_buffer_pool.h"
 #include <SDL.h>
 #include <cstddef>
 #include <condition_variable>
@@ -116,6 +117,9 @@ private:
 
     std::unordered_map<std::string, ThumbnailData> m_thumbnailCache;
     static constexpr size_t MAX_CACHED_THUMBNAILS = 100;
+    static constexpr size_t MIN_CACHED_THUMBNAILS = 12; // About one screen of the grid
+    size_t m_maxCachedThumbnails{MAX_CACHED_THUMBNAILS}; // Lowered by the MemoryGovernor
+    int m_memoryConsumerId{0};
     std::list<std::string> m_thumbnailUsage;
     std::unordered_map<std::string, std::list<std::string>::iterator> m_thumbnailUsageLookup;
 
@@ -165,7 +169,7 @@ private:
     struct ThumbnailJobResult
     {
         std::string fullPath;
-        std::vector<uint32_t> pixels;
+        PixelBufferPool::BufferPtr pixels;
         int width{0};
         int height{0};
         bool success{false};
@@ -251,6 +255,7 @@ private:
     void clearPendingThumbnails();
     void recordThumbnailUsage(const std::string& path);
     void evictOldThumbnails();
+    size_t thumbnailBytes() const;
     void cancelThumbnailJobsForPath(const std::string& path);
     void removeThumbnailEntry(const std::string& path);
     void tryRestoreSelection(const std::string& directoryPath);
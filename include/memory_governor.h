@@ -0,0 +1,100 @@
+#ifndef MEMORY_GOVERNOR_H
+#define MEMORY_GOVERNOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Process-wide coordinator for the reader's memory-hungry caches.
+ *
+ * Each cache registers itself as a consumer. poll() reads the memory left to
+ * the process from /proc/meminfo and the cgroup limits (v2 or v1), whichever
+ * is tighter, and hands every consumer with a share a budget proportional to
+ * what is actually free instead of a fixed constant. When free memory drops
+ * under the pressure threshold, consumers are asked to shed in shrink order,
+ * one more step on every poll until the pressure is gone: the MuPDF store
+ * first, then prerendered pages, thumbnails and finally display lists.
+ * SDL_READER_MEMORY_LIMIT_MB imposes an artificial limit (available memory
+ * is then that limit minus the resident set), which makes the shedding easy
+ * to exercise on a desktop.
+ * Callbacks run on the thread that calls poll(), outside the governor's lock.
+ * Register, unregister and poll from the UI thread; getStats() is thread-safe.
+ */
+class MemoryGovernor
+{
+public:
+    struct Consumer
+    {
+        std::string name;
+        int shrinkOrder = 0;   // Lower sheds first
+        double share = 0.0;    // Fraction of the usable memory; 0 = shed only
+        size_t maxBytes = 0;   // The consumer's own default budget, never exceeded
+        std::function<size_t()> usage;
+        std::function<void(size_t)> setBudget;
+        std::function<void()> shed;
+    };
+
+    struct Snapshot
+    {
+        uint64_t limitBytes = 0;
+        uint64_t availableBytes = 0;
+        std::string source; // Which reading set the available figure
+    };
+
+    struct Stats
+    {
+        Snapshot memory;
+        bool underPressure = false;
+        uint64_t pressureEvents = 0;
+        uint64_t sheds = 0;
+        size_t consumers = 0;
+    };
+
+    static MemoryGovernor& shared();
+
+    int registerConsumer(Consumer consumer);
+    void unregisterConsumer(int id);
+
+    // Re-read memory and rebalance. Cheap to call every frame; the work is
+    // rate-limited (faster while under pressure).
+    void poll(uint32_t nowMs);
+
+    Snapshot readMemory() const;
+    Stats getStats() const;
+
+    // Take poll()'s readings from source instead of readMemory(); an empty
+    // function restores the system readings. Lets tests and simulations
+    // drive the governor with made-up limits.
+    void setMemorySource(std::function<Snapshot()> source);
+
+    // Resident set size of this process, or 0 where /proc is not available
+    static uint64_t residentBytes();
+
+private:
+    MemoryGovernor() = default;
+
+    struct Registration
+    {
+        int id = 0;
+        Consumer consumer;
+        size_t appliedBudget = 0;
+    };
+
+    static constexpr uint32_t POLL_INTERVAL_MS = 2000;
+    static constexpr uint32_t PRESSURE_POLL_INTERVAL_MS = 500;
+
+    mutable std::mutex m_mutex;
+    std::vector<Registration> m_consumers; // Sorted by shrink order
+    int m_nextId = 1;
+    bool m_polled = false;
+    uint32_t m_lastPollMs = 0;
+    size_t m_shedLevel = 0; // Next consumer to shed while under pressure
+    std::function<Snapshot()> m_memorySource;
+    Stats m_stats;
+};
+
+#endif // MEMORY_GOVERNOR_H
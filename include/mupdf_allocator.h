@@ -0,0 +1,105 @@
+#ifndef MUPDF_ALLOCATOR_H
+#define MUPDF_ALLOCATOR_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mupdf/fitz.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief fz_alloc_context that pools small blocks and counts MuPDF's memory use.
+ *
+ * Blocks up to MAX_POOLED_BYTES come from per-size-class free lists carved out
+ * of 64KB slabs, so the many short-lived nodes, paths and glyph runs created
+ * while running display lists do not fragment the heap. Larger blocks go to
+ * malloc. Every block carries a small header with its size, which lets the
+ * allocator track current and peak bytes per base context (clones share their
+ * base context's allocator).
+ * With a byte budget set, requests past it fail. MuPDF then evicts from its
+ * store and retries before it reports an out-of-memory error.
+ * Slabs are kept for reuse and only freed with the allocator, so an allocator
+ * must outlive every context created with it. Thread-safe.
+ * Each thread also keeps a running net count of the bytes it has allocated
+ * through any allocator, so the cost of one operation can be read as the
+ * difference across it without other threads' traffic mixing in.
+ */
+class MuPdfAllocator
+{
+public:
+    struct Stats
+    {
+        std::string name;
+        size_t currentBytes = 0;
+        size_t peakBytes = 0;
+        size_t budgetBytes = 0; // 0 = unlimited
+        size_t slabBytes = 0;   // Reserved for pooled blocks
+        uint64_t allocations = 0;
+        uint64_t pooledAllocations = 0;
+        uint64_t refused = 0; // Requests over the budget
+    };
+
+    explicit MuPdfAllocator(std::string name, size_t budgetBytes = 0);
+    ~MuPdfAllocator();
+
+    MuPdfAllocator(const MuPdfAllocator&) = delete;
+    MuPdfAllocator& operator=(const MuPdfAllocator&) = delete;
+
+    // Pass to fz_new_context()
+    const fz_alloc_context* allocContext() const
+    {
+        return &m_allocContext;
+    }
+
+    void setBudget(size_t bytes);
+    Stats getStats() const;
+
+    // One log line: "name: current/peak KB, ..."
+    std::string describe() const;
+
+    // Bytes allocated minus bytes freed by the calling thread, across all
+    // allocators. Only differences are meaningful.
+    static int64_t threadNetBytes();
+
+private:
+    static constexpr size_t SIZE_CLASS_COUNT = 6; // 16 .. 512 payload bytes
+    static constexpr size_t MAX_POOLED_BYTES = 512;
+    static constexpr size_t SLAB_BYTES = 64 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    static void* allocCallback(void* user, size_t size);
+    static void* reallocCallback(void* user, void* old, size_t size);
+    static void freeCallback(void* user, void* ptr);
+
+    void* allocate(size_t size);
+    void* reallocate(void* old, size_t size);
+    void release(void* ptr);
+    void* allocatePooled(size_t sizeClass);
+    bool reserve(size_t size);
+    void unreserve(size_t size);
+
+    std::string m_name;
+    fz_alloc_context m_allocContext;
+
+    mutable std::mutex m_poolMutex;
+    std::array<FreeBlock*, SIZE_CLASS_COUNT> m_freeLists{};
+    std::vector<void*> m_slabs;
+    std::array<size_t, SIZE_CLASS_COUNT> m_slabRemaining{};
+    std::array<unsigned char*, SIZE_CLASS_COUNT> m_slabCursor{};
+
+    std::atomic<size_t> m_currentBytes{0};
+    std::atomic<size_t> m_peakBytes{0};
+    std::atomic<size_t> m_budgetBytes{0};
+    std::atomic<uint64_t> m_allocations{0};
+    std::atomic<uint64_t> m_pooledAllocations{0};
+    std::atomic<uint64_t> m_refused{0};
+};
+
+#endif // MUPDF_ALLOCATOR_H
@@ -0,0 +1,68 @@
+#ifndef MUPDF_CONTEXT_POOL_H
+#define MUPDF_CONTEXT_POOL_H
+
+#include "mupdf_allocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mupdf/fitz.h>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Process-wide pool of long-lived MuPDF base contexts.
+ *
+ * Dropping a context is unsafe here (fz_drop_context() can exit the process
+ * when warnings have piled up), so contexts are never destroyed. Instead a
+ * closed document hands its context back: the store is emptied, the user CSS,
+ * anti-aliasing and system font loader are reset, and the next document
+ * reuses it. In browse mode the number of contexts therefore stays at the
+ * number open at once instead of growing with every book. Contexts share getSharedMuPdfLocks().
+ * Each one allocates through its own MuPdfAllocator, whose counters
+ * getAllocatorStats() reports.
+ * Clones made from a pooled context are owned and dropped by their user.
+ * All methods are thread-safe.
+ */
+class MuPdfContextPool
+{
+public:
+    struct Stats
+    {
+        size_t created = 0;
+        uint64_t reused = 0;
+        size_t idle = 0;
+    };
+
+    static MuPdfContextPool& shared();
+
+    // A context with the document handlers registered, or nullptr if MuPDF
+    // cannot create one
+    fz_context* acquire();
+    // Reset a context from acquire() and keep it for the next caller. The
+    // caller must have dropped its documents and clones first.
+    void release(fz_context* ctx);
+
+    Stats getStats() const;
+    std::vector<MuPdfAllocator::Stats> getAllocatorStats() const;
+    void logAllocatorStats() const;
+
+private:
+    MuPdfContextPool() = default;
+
+#ifdef TRIMUI_PLATFORM
+    static constexpr size_t STORE_BYTES = 128u << 20;
+    static constexpr size_t ALLOCATION_BUDGET_BYTES = 256u << 20; // Store plus live pages and lists
+#else
+    static constexpr size_t STORE_BYTES = 256u << 20;
+    static constexpr size_t ALLOCATION_BUDGET_BYTES = 0; // Unlimited
+#endif
+
+    mutable std::mutex m_mutex;
+    std::vector<fz_context*> m_idle;
+    std::vector<std::unique_ptr<MuPdfAllocator>> m_allocators; // One per created context, never freed
+    size_t m_created = 0;
+    size_t m_nextIndex = 0; // Allocator name of the next context, taken before it is created
+    uint64_t m_reused = 0;
+};
+
+#endif // MUPDF_CONTEXT_POOL_H
@@ -1,15 +1,21 @@
 #ifndef MUPDF_DOCUMENT_H
 #define MUPDF_DOCUMENT_H
 
+#include "disk_page_cache.h"
 #include "document.h"
+#include "mupdf_context_pool.h"
+#include "page_cache.h"
+#include "pixel_buffer_pool.h"
+#include "render_worker_pool.h"
 #include <atomic>
-#include <condition_variable>
-#include <deque>
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mupdf/fitz.h>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <tuple>
@@ -30,13 +36,39 @@
 class MuPdfDocument : public Document
 {
 public:
-    using ArgbBufferPtr = std::shared_ptr<const std::vector<uint32_t>>;
+    using ArgbBufferPtr = PageCache::ArgbBufferPtr;
 
     MuPdfDocument();
     ~MuPdfDocument() override;
 
     std::vector<unsigned char> renderPage(int page, int& width, int& height, int scale) override;
     ArgbBufferPtr renderPageARGB(int page, int& width, int& height, int scale);
+
+    // Zero-copy render into caller memory such as a locked streaming texture.
+    // acquire(width, height, pitch) is called once the page size is known and
+    // returns the destination (pitch in bytes) or nullptr to give up, in which
+    // case this returns false. The pixels are not added to the page cache.
+    using PixelTarget = std::function<uint32_t*(int width, int height, int& pitch)>;
+    bool renderPageARGBInto(int page, int scale, int& width, int& height, const PixelTarget& acquire);
+
+    // While set, the two synchronous renders above use reduced anti-aliasing and
+    // keep their results out of the page and disk caches, so the next frame
+    // falls back to a full-quality render. Meant for zoom and page-flip bursts.
+    void setDraftRendering(bool enabled)
+    {
+        m_draftRendering = enabled;
+    }
+    bool isDraftRendering() const
+    {
+        return m_draftRendering.load();
+    }
+
+    // Quick low-resolution pass for progressive display, queued on a worker
+    // ahead of the full render so the caller's thread never interprets the
+    // page. The result lands in the page cache at scale (not the disk cache),
+    // where tryGetCachedPageARGB() finds it; the caller stretches it until the
+    // full render is ready.
+    void requestPagePreviewAsync(int page, int scale);
     int getPageWidthNative(int page) override;
     int getPageHeightNative(int page) override;
     int getPageWidthEffective(int page, int zoom);
@@ -44,8 +76,45 @@ public:
     std::pair<int, int> getPageDimensionsEffective(int page, int zoom);
     bool tryGetCachedPageARGB(int page, int scale, ArgbBufferPtr& buffer, int& width, int& height);
     void requestPageRenderAsync(int page, int scale);
+
+    // Tiled rendering for high zoom levels. Tiles are TILE_SIZE squares in the
+    // page's pixel space at the given scale (edge tiles are smaller), so only the
+    // visible region has to be rasterized.
+#ifdef TRIMUI_PLATFORM
+    static constexpr int TILE_SIZE = 256;
+#else
+    static constexpr int TILE_SIZE = 512;
+#endif
+    static constexpr int TILED_RENDER_MIN_SCALE = 200;
+    void setTiledRenderingEnabled(bool enabled);
+    bool shouldUseTiledRendering(int scale) const;
+    bool tryGetCachedTileARGB(int page, int scale, int tileX, int tileY, ArgbBufferPtr& buffer, int& width, int& height);
+    ArgbBufferPtr renderTileARGB(int page, int scale, int tileX, int tileY, int& width, int& height);
+    void requestTileRenderAsync(int page, int scale, int tileX, int tileY);
+
+    // Render ahead for the zoom step the reader is likely to take next (a whole
+    // page, or one tile at tiled scales). Used counts speculative renders that
+    // were later shown.
+    struct SpeculativeStats
+    {
+        uint64_t rendered = 0;
+        uint64_t used = 0;
+    };
+    void requestSpeculativeRender(int page, int scale, int tileX = -1, int tileY = -1);
+    SpeculativeStats getSpeculativeStats() const;
     bool open(const std::string& filePath) override;
     bool reopenWithCSS(const std::string& css); // Reopen document with new CSS
+
+    // Apply new CSS to a reflowable document without blocking: a worker lays
+    // the book out with css on its own context, maps currentPage across the
+    // layouts with a MuPDF bookmark and renders the mapped page at scale while
+    // the current layout keeps drawing. Returns false for documents that are
+    // not laid out by CSS; reopenWithCSS() is the way to restyle those.
+    bool beginRelayout(const std::string& css, int currentPage, int scale);
+    // Once the worker is done, switch to the new layout in one step (swap in
+    // the worker's document, seed the prepared page) and report where
+    // currentPage, the page on screen now, landed in it
+    bool finishRelayout(int currentPage, int& mappedPage);
     int getPageCount() const override;
     void setMaxRenderSize(int width, int height);
     void close() override;
@@ -53,19 +122,71 @@ public:
     // Clear the render cache
     void clearCache();
 
+    // Rendered page cache budget and hit/miss/eviction counters
+    void setPageCacheBudget(size_t bytes);
+    PageCache::Stats getPageCacheStats() const;
+
+    // Display lists (one per visited page) are kept under a byte budget, least
+    // recently used first. Sizes are estimates; the pages around the current
+    // one are never evicted.
+    struct DisplayListStats
+    {
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t budgetBytes = 0;
+        uint64_t builds = 0;
+        uint64_t evictions = 0;
+    };
+    void setDisplayListBudget(size_t bytes);
+    DisplayListStats getDisplayListStats() const;
+
+    // Memory pressure relief, cheapest to lose first: shrink MuPDF's resource
+    // store to percent of its current size, drop rendered pages other than
+    // the current one, and drop every display list outside the pinned window
+    void shrinkStore(int percent);
+    void dropPrerenderedPages();
+    void releaseDisplayLists();
+
+    // Optional persistent cache of rendered pages, usually shared by every
+    // document opened in the session. Whole-page renders are written to it in
+    // the background; tryLoadPageFromDiskCache() reads a page back (and adds it
+    // to the in-memory cache) so reopening a book skips the MuPDF render.
+    void setDiskPageCache(std::shared_ptr<DiskPageCache> cache);
+    bool tryLoadPageFromDiskCache(int page, int scale, ArgbBufferPtr& buffer, int& width, int& height);
+
+    // Progress of a background whole-page render of the page, read from its
+    // fz_cookie. progressMax is 0 while MuPDF cannot tell the amount of work
+    // (interpreting the page); rasterizing the display list reports both.
+    // The render thread keeps writing while this samples, so the fraction is
+    // approximate. Synchronous renders report nothing: they block the thread
+    // that would draw the progress.
+    struct RenderProgress
+    {
+        bool active = false;
+        int progress = 0;
+        size_t progressMax = 0;
+        uint32_t elapsedMs = 0;
+    };
+    RenderProgress getRenderProgress(int page) const;
+
     // Cancel any ongoing background prerendering
     void cancelPrerendering();
 
-    // Check if background prerendering is currently active
-    bool isPrerenderingActive() const
-    {
-        return m_prerenderActive;
-    }
+    // Check if background prerendering is currently queued or running
+    bool isPrerenderingActive() const;
+
+    // Number of background render workers (persistent, shared by all async work)
+    void setRenderWorkerCount(int count);
+    int getRenderWorkerCount() const;
 
     // Prerender pages for faster page changes
     void prerenderPage(int pageNumber, int scale);
     void prerenderAdjacentPages(int currentPage, int scale);
     void prerenderAdjacentPagesAsync(int currentPage, int scale);
+    // Queue background renders of pages in the given order (see PrefetchPredictor).
+    // False if the request was dropped: tiled zoom, cooldown, or a prerender
+    // still running.
+    bool prerenderPagesAsync(int currentPage, const std::vector<int>& pages, int scale);
 
     // CSS styling for documents (EPUB/MOBI/TXT)
     void setUserCSSBeforeOpen(const std::string& css); // Set CSS before opening document
@@ -80,6 +201,14 @@ public:
         return m_ctx.get();
     }
 
+    // Installs the custom font loader on the other base contexts the
+    // document opens itself (the background relayout's), which do not share
+    // getContext()'s font setup
+    void setFontLoaderInstaller(std::function<void(fz_context*)> installer)
+    {
+        m_fontLoaderInstaller = std::move(installer);
+    }
+
     // Page count handling
     bool isPageCountFinal() const
     {
@@ -111,17 +240,19 @@ private:
     {
         void operator()(fz_context* ctx) const
         {
+            // Base contexts are never dropped: fz_drop_context() can call exit()
+            // when errors/warnings have accumulated, which ended the process when
+            // returning to the file browser. The pool resets and reuses them.
+            MuPdfContextPool::shared().release(ctx);
+        }
+    };
+    struct CloneDeleter
+    {
+        void operator()(fz_context* ctx) const
+        {
+            // A clone only holds references into its base context's store
             if (ctx)
-            {
-                std::cout.flush();
-                // NOTE: We do NOT call fz_drop_context() here because:
-                // 1. MuPDF's fz_drop_context() can call exit() if there are accumulated errors/warnings
-                // 2. This causes the entire process to terminate unexpectedly when returning to file browser
-                // 3. Contexts will be cleaned up when the process exits
-                // 4. This is safe because MuPDF contexts are designed to persist for the app lifetime
-                std::cout.flush();
-                // fz_drop_context(ctx); // COMMENTED OUT - causes exit() in browse mode
-            }
+                fz_drop_context(ctx);
         }
     };
     struct DocumentDeleter
@@ -134,10 +265,7 @@ private:
         void operator()(fz_document* doc) const
         {
             if (doc && ctx)
-            {
-                // Intentionally skip dropping the MuPDF document to avoid shutdown-time double frees.
-                // The process lifetime holds these allocations, so leaking them is acceptable.
-            }
+                fz_drop_document(ctx, doc);
         }
     };
     struct PixmapDeleter
@@ -170,6 +298,8 @@ private:
     {
         std::unique_ptr<fz_display_list, DisplayListDeleter> displayList;
         fz_rect bounds{};
+        size_t bytes = 0;     // Estimated memory held by displayList
+        uint64_t lastUse = 0; // m_displayListUseCounter at the last lookup
     };
 
     struct PageScaleInfo;
@@ -177,35 +307,105 @@ private:
     std::unique_ptr<fz_context, ContextDeleter> m_ctx;
     std::unique_ptr<fz_document, DocumentDeleter> m_doc;
 
-    // Separate context for background prerendering to avoid race conditions
-    std::unique_ptr<fz_context, ContextDeleter> m_prerenderCtx;
-    std::unique_ptr<fz_document, DocumentDeleter> m_prerenderDoc;
-    std::mutex m_prerenderMutex; // Protects prerender context operations
+    // Contexts cloned from m_ctx for banded rasterization, one per band. They
+    // share m_ctx's store and locks and are only used while m_renderMutex is
+    // held. The bands run on m_bandPool, whose workers persist across pages.
+    std::vector<std::unique_ptr<fz_context, CloneDeleter>> m_rasterContexts;
+    fz_context* m_rasterContextsBase = nullptr;
+    RenderWorkerPool m_bandPool;
+    uint32_t m_bandSerial = 0; // Guarded by m_renderMutex
+
+    // Contexts cloned from m_ctx that tiles and background renders use to
+    // rasterize cached display lists outside m_renderMutex. Each render takes
+    // one for itself and hands it back, so workers rasterize in parallel.
+    // Guarded by m_workerRasterMutex.
+    std::mutex m_workerRasterMutex;
+    std::vector<std::unique_ptr<fz_context, CloneDeleter>> m_idleRasterContexts;
+    fz_context* m_workerRasterBase = nullptr;
+
+    PageCache m_pageCache; // Rendered ARGB/RGB pages, LRU under a byte budget
+    std::shared_ptr<DiskPageCache> m_diskCache;
+    std::string m_documentIdentity; // DiskPageCache::documentIdentity() of the open file
 
-    std::map<std::pair<int, int>, std::tuple<std::vector<unsigned char>, int, int>> m_cache;
-    std::map<std::pair<int, int>, std::tuple<ArgbBufferPtr, int, int>> m_argbCache;
+    // Layout facts persisted in the metadata sidecar (document_metadata.h) so a
+    // second open knows the page count and page sizes without loading pages.
+    std::vector<fz_rect> m_knownPageBounds;      // Guarded by m_pageDataMutex; empty rect = unknown
+    std::atomic<bool> m_pageCountCounted{false}; // m_pageCount came from fz_count_pages
+    std::atomic<bool> m_metadataDirty{false};
+    std::string m_metadataCss; // CSS the open document was laid out with
+    std::string m_acceleratorPath; // MuPDF layout accelerator for reflowable documents, else empty
+    std::mutex m_metadataMutex; // Serializes sidecar writes
     std::map<std::pair<int, int>, std::pair<int, int>> m_dimensionCache;
-    std::mutex m_cacheMutex;
     std::mutex m_renderMutex; // Protects MuPDF context operations
-    std::mutex m_pageDataMutex;
+    mutable std::mutex m_pageDataMutex;
+
+    // Display list accounting, guarded by m_pageDataMutex
+    size_t m_displayListBytes = 0;
+    size_t m_displayListBudget;
+    uint64_t m_displayListUseCounter = 0;
+    uint64_t m_displayListBuilds = 0;
+    uint64_t m_displayListEvictions = 0;
+    std::atomic<int> m_focusPage{0}; // Page the reader is on; its neighbours stay pinned
+
+    // Speculatively rendered cache entries not yet shown
+    mutable std::mutex m_speculativeMutex;
+    std::set<PageCache::Key> m_speculativeKeys;
+    SpeculativeStats m_speculativeStats;
+    void noteCachedRenderShown(const PageCache::Key& key);
     int m_maxWidth = 2560;  // Increased for better performance at high zoom levels
     int m_maxHeight = 1920; // Increased for better performance at high zoom levels
+    std::atomic<bool> m_tiledRenderingEnabled{true};
     std::atomic<int> m_pageCount{0};
     std::vector<PageDisplayData> m_pageDisplayData;
     std::atomic<bool> m_pageCountFinal{false};
     std::atomic<bool> m_pageCountEstimated{false};
     bool m_isPdfDocument = false;
     bool m_isReflowableDocument = false;
-    std::thread m_pageCountThread;
-    std::atomic<bool> m_pageCountThreadActive{false};
 
     // Background prerendering support
-    std::thread m_prerenderThread;
-    std::atomic<bool> m_prerenderActive{false};
     std::chrono::steady_clock::time_point m_lastPrerenderTime;
     static constexpr int PRERENDER_COOLDOWN_MS = 50; // Minimum time between prerendering operations
     std::atomic<uint64_t> m_prerenderGeneration{0};
 
+    // Cookies of in-flight background renders. cancelPrerendering() sets
+    // abort on every cookie registered under an older generation so MuPDF
+    // stops mid-page instead of finishing a render nobody will see.
+    struct ActiveCookie
+    {
+        fz_cookie* cookie;
+        uint64_t generation;
+        int page; // Whole-page render of this page, or -1
+        std::chrono::steady_clock::time_point start;
+    };
+    mutable std::mutex m_cookieMutex;
+    std::vector<ActiveCookie> m_activeCookies;
+
+    class ScopedRenderCookie
+    {
+    public:
+        // Pass the page for whole-page renders to report progress and timing
+        ScopedRenderCookie(MuPdfDocument& owner, uint64_t generation, int page = -1);
+        ~ScopedRenderCookie();
+        ScopedRenderCookie(const ScopedRenderCookie&) = delete;
+        ScopedRenderCookie& operator=(const ScopedRenderCookie&) = delete;
+
+        fz_cookie* get()
+        {
+            return &m_cookie;
+        }
+        bool aborted() const
+        {
+            return m_cookie.abort != 0;
+        }
+
+    private:
+        MuPdfDocument& m_owner;
+        fz_cookie m_cookie{};
+        int m_page;
+        std::chrono::steady_clock::time_point m_start;
+    };
+    void abortStaleRenderCookies(uint64_t currentGeneration);
+
     // User CSS for styling documents
     std::string m_userCSS;
 
@@ -217,28 +417,79 @@ private:
     uint8_t m_bgG = 255;
     uint8_t m_bgB = 255;
 
-    // Asynchronous current page rendering support
-    std::thread m_asyncRenderThread;
-    std::mutex m_asyncRenderMutex;
-    std::condition_variable m_asyncRenderCv;
-    std::deque<std::pair<int, int>> m_asyncRenderQueue;
+    // Background work (async page renders, tiles, prerender, page count).
+    // m_asyncShutdown blocks new submissions while the document is closed.
+    RenderWorkerPool m_renderPool;
     std::atomic<bool> m_asyncShutdown{false};
-    std::atomic<bool> m_asyncWorkerRunning{false};
+    std::atomic<bool> m_pageCountAbort{false}; // Stops the chapter count at the next chapter
+    std::atomic<int> m_foregroundRenders{0};   // Synchronous page renders in progress
+    std::atomic<bool> m_draftRendering{false};
+
+    // Background relayout started by beginRelayout(), guarded by m_relayoutMutex.
+    // Results of superseded generations are ignored.
+    struct RelayoutState
+    {
+        uint64_t generation = 0;
+        bool pending = false;
+        bool ready = false;
+        std::string css;
+        int fromPage = 0;
+        int page = -1; // Mapped page, -1 if the worker failed
+        int scale = 0;
+        fz_rect bounds{};
+        ArgbBufferPtr pixels;
+        int width = 0;
+        int height = 0;
+        // The worker's pooled context and the document it laid out there,
+        // owned by the state until finishRelayout() makes them m_ctx/m_doc
+        fz_context* ctx = nullptr;
+        fz_document* doc = nullptr;
+    };
+    mutable std::mutex m_relayoutMutex;
+    RelayoutState m_relayout;
+    std::function<void(fz_context*)> m_fontLoaderInstaller; // Set before open
 
     // Helpers
-    void ensureDisplayList(int pageNumber);
+    void ensureDisplayList(int pageNumber, fz_cookie* cookie = nullptr);
+    void evictDisplayListsLocked(int keepPage);
     PageScaleInfo computePageScaleInfoLocked(int pageNumber, int zoom);
+    void computeScaleGeometry(PageScaleInfo& info, int zoom) const;
+    bool knownPageBounds(int pageNumber, fz_rect& bounds);
+    void recordPageBoundsLocked(int pageNumber, const fz_rect& bounds);
+    void saveMetadata();
+    unsigned char pageClearValue() const;
+    PixelBufferPool::BufferPtr rasterizeDisplayListARGB(fz_context* ctx, fz_display_list* list,
+                                                        const fz_matrix& transform, const fz_irect& bbox,
+                                                        int pageNumber, fz_cookie* cookie = nullptr,
+                                                        bool allowBanding = true);
+    void rasterizeDisplayListInto(fz_context* ctx, fz_display_list* list, const fz_matrix& transform,
+                                  const fz_irect& bbox, int pageNumber, uint32_t* dest, int destStride,
+                                  fz_cookie* cookie = nullptr, bool allowBanding = true);
+    ArgbBufferPtr renderTileARGB(int page, int scale, int tileX, int tileY, int& width, int& height,
+                                 fz_cookie* cookie);
+    int rasterBandCount(int width, int height) const;
+    int ensureRasterContextsLocked(fz_context* ctx, int count);
+    fz_context* acquireWorkerRasterContextLocked();
+    void releaseWorkerRasterContext(fz_context* clone);
     void resetDisplayCache();
-    void joinAsyncRenderThread();
+    bool diskCacheKey(int pageNumber, int scale, DiskPageCache::Key& key) const;
+    void queueDiskCacheWrite(int pageNumber, int scale, const ArgbBufferPtr& buffer, int width, int height);
+    void drainRenderPool();
+    void releaseMuPdfResources(); // Clones, display lists, document, then the context back to the pool
     bool isPrerenderRequestStale(uint64_t generationToken) const;
-    void prerenderPageInternal(int pageNumber, int scale, uint64_t generationToken);
+    void prerenderPageInternal(int pageNumber, int scale, uint64_t generationToken, bool toDiskCache = true);
     void prerenderAdjacentPagesInternal(int currentPage, int scale, uint64_t generationToken);
-    void asyncRenderWorker();
-    bool isRenderableQueued(const std::pair<int, int>& key);
-    bool renderPageARGBWithPrerenderContext(int pageNumber, int zoom, std::vector<uint32_t>& buffer,
-                                            int& width, int& height);
+    void renderPageAsyncJob(int pageNumber, int scale, uint64_t generationToken);
+    ArgbBufferPtr renderPageARGBImpl(int pageNumber, int& width, int& height, int zoom, bool draft);
     void startAsyncPageCount();
     void stopPageCountThread();
+    int countPagesByChapter(fz_context* ctx); // Lays out m_doc chapter by chapter on ctx
+    void relayoutJob(const std::string& path, const std::string& identity, const std::string& css,
+                     fz_bookmark mark, int scale, unsigned char clearValue, uint64_t generation);
+    // Returns the page currentPage maps to in the adopted layout
+    int adoptRelayoutDocument(RelayoutState& done, int currentPage);
+    static void discardRelayoutDocument(RelayoutState& state);
+    void loadLayoutState(); // Page count and known bounds of m_doc's current layout
     void finalizePageCount(int newCount);
 };
 
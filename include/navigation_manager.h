@@ -1,6 +1,7 @@
 #ifndef NAVIGATION_MANAGER_H
 #define NAVIGATION_MANAGER_H
 
+#include "prefetch_predictor.h"
 #include <SDL.h>
 #include <algorithm>
 #include <functional>
@@ -97,6 +98,16 @@ public:
     {
         return m_state.pageJumpBuffer;
     }
+    Uint32 getLastRenderDuration() const
+    {
+        return m_state.lastRenderDuration;
+    }
+
+    // Learns from page changes which pages to prerender next
+    PrefetchPredictor& getPrefetchPredictor()
+    {
+        return m_prefetchPredictor;
+    }
 
     // Page navigation
     bool goToNextPage(Document* document, ViewportManager* viewportManager, std::function<void(int)> setCurrentPageCallback,
@@ -131,6 +142,7 @@ public:
 private:
     NavigationState m_state;
     bool m_keepPanningPosition = false; // Setting for whether to keep panning position on page change
+    PrefetchPredictor m_prefetchPredictor;
 
     // Internal page change implementation
     void performPageChange(int newPage, Document* document, ViewportManager* viewportManager, std::function<void(int)> setCurrentPageCallback,
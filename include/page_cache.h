@@ -0,0 +1,136 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Byte-budgeted LRU cache for rendered pages keyed by (page, scale).
+ *
+ * Tiles of a page rendered at high zoom share the cache (and the budget)
+ * with whole pages; they carry their tile column/row in the key.
+ * An entry can hold an ARGB buffer, an RGB24 buffer or both for the same page.
+ * A successful lookup promotes the entry to most recently used. After each
+ * insert, entries are evicted from the least recently used end until the total
+ * size fits the budget. The newest entry is always kept, even when it alone
+ * exceeds the budget.
+ * All methods are thread-safe.
+ */
+class PageCache
+{
+public:
+    struct Key
+    {
+        int page = 0;
+        int scale = 0;
+        int tileX = -1; // -1 for whole-page entries
+        int tileY = -1;
+
+        Key() = default;
+        Key(int pageNumber, int pageScale, int tileColumn = -1, int tileRow = -1)
+            : page(pageNumber), scale(pageScale), tileX(tileColumn), tileY(tileRow)
+        {
+        }
+
+        bool isTile() const
+        {
+            return tileX >= 0 && tileY >= 0;
+        }
+        bool operator<(const Key& other) const
+        {
+            return std::tie(page, scale, tileX, tileY) < std::tie(other.page, other.scale, other.tileX, other.tileY);
+        }
+        bool operator==(const Key& other) const
+        {
+            return page == other.page && scale == other.scale && tileX == other.tileX && tileY == other.tileY;
+        }
+    };
+
+    using ArgbBufferPtr = std::shared_ptr<const std::vector<uint32_t>>;
+    using RgbBufferPtr = std::shared_ptr<const std::vector<unsigned char>>;
+
+    struct Entry
+    {
+        ArgbBufferPtr argb;
+        RgbBufferPtr rgb;
+        int width = 0;
+        int height = 0;
+    };
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t budgetBytes = 0;
+    };
+
+    explicit PageCache(size_t budgetBytes = defaultBudgetBytes());
+
+    // Per-platform default budget
+    static size_t defaultBudgetBytes();
+
+    // Which buffer a lookup needs; an entry without it counts as a miss
+    enum class Format
+    {
+        Any,
+        Argb,
+        Rgb
+    };
+
+    // Look up an entry, promoting it and counting a hit or miss
+    bool find(const Key& key, Entry& entry, Format format = Format::Any);
+
+    // Presence checks that neither promote nor touch the counters
+    bool contains(const Key& key) const;
+    bool containsArgb(const Key& key) const;
+
+    // Attach a buffer to the entry for key. A buffer of the other format is kept
+    // only when its dimensions match.
+    void putArgb(const Key& key, ArgbBufferPtr buffer, int width, int height);
+    void putRgb(const Key& key, RgbBufferPtr buffer, int width, int height);
+
+    void erase(const Key& key);
+    // Erase every entry whose key matches; returns how many went
+    size_t eraseIf(const std::function<bool(const Key&)>& predicate);
+    void clear();
+
+    void setBudgetBytes(size_t budgetBytes);
+    size_t getBudgetBytes() const;
+
+    Stats getStats() const;
+
+private:
+    struct Node
+    {
+        Entry entry;
+        size_t bytes = 0;
+        std::list<Key>::iterator lruIt;
+    };
+
+    static size_t entryBytes(const Entry& entry);
+    Node& touchLocked(const Key& key);
+    void accountLocked(Node& node);
+    void evictLocked(const Key& keep);
+
+    mutable std::mutex m_mutex;
+    std::map<Key, Node> m_entries;
+    std::list<Key> m_lru; // front = most recently used
+    size_t m_bytes = 0;
+    size_t m_budgetBytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_evictions = 0;
+};
+
+#endif // PAGE_CACHE_H
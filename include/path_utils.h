@@ -23,4 +23,14 @@ std::filesystem::path getStateDirectory();
 std::filesystem::path getDefaultConfigPath();
 std::filesystem::path getDefaultHistoryPath();
 
+/**
+ * @brief Directory for the persistent rendered-page cache (not created here).
+ */
+std::filesystem::path getDefaultPageCacheDirectory();
+
+/**
+ * @brief Directory for per-document metadata sidecars (not created here).
+ */
+std::filesystem::path getDefaultMetadataDirectory();
+
 #endif // PATH_UTILS_H
@@ -0,0 +1,83 @@
+#ifndef PIXEL_BUFFER_POOL_H
+#define PIXEL_BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Process-wide pool of ARGB pixel vectors for render output.
+ *
+ * A whole page is several megabytes, and every render used to allocate a
+ * fresh vector and free it when the last shared_ptr dropped, so each page
+ * turn faulted in new memory and fragmented the heap. acquire() hands out a
+ * buffer whose shared_ptr deleter puts the vector back into the pool instead
+ * of freeing it. Capacities are rounded up to size classes 1/8 of a power of
+ * two apart, so pages of slightly different sizes reuse each other's buffers.
+ * Idle buffers are kept under a byte budget, oldest dropped first; the
+ * rendered page cache sets it from its own budget.
+ * The contents of an acquired buffer are unspecified; callers overwrite
+ * every pixel. All methods are thread-safe.
+ */
+class PixelBufferPool
+{
+public:
+    using Buffer = std::vector<uint32_t>;
+    using BufferPtr = std::shared_ptr<Buffer>;
+
+    struct Stats
+    {
+        uint64_t acquired = 0;  // Pooled requests
+        uint64_t reused = 0;    // ... served from an idle buffer: allocations avoided
+        uint64_t allocated = 0; // ... that needed a new vector
+        uint64_t released = 0;  // Idle buffers freed to stay under the budget
+        size_t idleBuffers = 0;
+        size_t idleBytes = 0;
+        size_t budgetBytes = 0;
+    };
+
+    // Idle buffers may hold 1/CACHE_BUDGET_DIVISOR of the rendered page cache budget
+    static constexpr size_t CACHE_BUDGET_DIVISOR = 4;
+
+    static PixelBufferPool& shared();
+
+    // A buffer of exactly pixelCount pixels
+    BufferPtr acquire(size_t pixelCount);
+    // Take over a vector filled elsewhere so it returns to the pool when done
+    BufferPtr adopt(Buffer&& pixels);
+
+    void setBudgetBytes(size_t budgetBytes);
+    // Free idle buffers until at most keepBytes remain
+    void trim(size_t keepBytes);
+
+    Stats getStats() const;
+
+private:
+    PixelBufferPool();
+
+    struct Recycler
+    {
+        PixelBufferPool* pool;
+        void operator()(Buffer* buffer) const;
+    };
+
+    static constexpr size_t MIN_POOLED_PIXELS = 4096; // Smaller buffers are not worth keeping
+
+    static size_t classCapacity(size_t pixelCount);
+    void recycle(Buffer* buffer);
+    void trimLocked(size_t keepBytes, std::vector<Buffer*>& released);
+
+    mutable std::mutex m_mutex;
+    std::deque<Buffer*> m_idle; // Oldest first
+    size_t m_idleBytes = 0;
+    size_t m_budgetBytes = 0;
+    uint64_t m_acquired = 0;
+    uint64_t m_reused = 0;
+    uint64_t m_allocated = 0;
+    uint64_t m_released = 0;
+};
+
+#endif // PIXEL_BUFFER_POOL_H
@@ -0,0 +1,66 @@
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Pixel conversion kernels for the render hot paths.
+ *
+ * ARGB values are 32-bit words laid out as 0xAARRGGBB (SDL_PIXELFORMAT_ARGB8888).
+ * Every kernel has a scalar reference implementation; vector versions (NEON on
+ * ARM, SSE2/AVX2 on x86) are chosen once on first use from the CPU's features and
+ * checked against the scalar output before they are trusted.
+ */
+namespace pixel_convert
+{
+enum class Isa
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon
+};
+
+// Instruction set the kernels below dispatch to
+Isa activeIsa();
+const char* isaName(Isa isa);
+
+// One implementation of each converting kernel. Kernels an instruction set
+// has no vector version of are the scalar ones.
+struct Kernels
+{
+    Isa isa = Isa::Scalar;
+    void (*rgbaToArgb)(const uint8_t* src, uint32_t* dst, size_t count) = nullptr;
+    void (*rgbToArgb)(const uint8_t* src, uint32_t* dst, size_t count) = nullptr;
+    void (*argbToRgb)(const uint32_t* src, uint8_t* dst, size_t count) = nullptr;
+};
+
+// The kernels for isa, whether or not they are the active ones. False if
+// they are not built for this target or the CPU lacks the instructions.
+// Used by the tests to check every vector kernel against the scalar one.
+bool kernelsFor(Isa isa, Kernels& kernels);
+
+// count pixels of R,G,B,A bytes to ARGB words
+void rgbaToArgb(const uint8_t* src, uint32_t* dst, size_t count);
+
+// count pixels of R,G,B bytes to opaque ARGB words
+void rgbToArgb(const uint8_t* src, uint32_t* dst, size_t count);
+
+// count ARGB words to R,G,B bytes (alpha dropped)
+void argbToRgb(const uint32_t* src, uint8_t* dst, size_t count);
+
+// Copy width x height 32-bit pixels from rows srcPitch bytes apart into a
+// tightly packed buffer
+void copyRows32(const uint8_t* src, int srcPitch, uint32_t* dst, int width, int height);
+
+// Reference implementations used for the self-check and unsupported CPUs
+namespace scalar
+{
+void rgbaToArgb(const uint8_t* src, uint32_t* dst, size_t count);
+void rgbToArgb(const uint8_t* src, uint32_t* dst, size_t count);
+void argbToRgb(const uint32_t* src, uint8_t* dst, size_t count);
+} // namespace scalar
+} // namespace pixel_convert
+
+#endif // PIXEL_CONVERT_H
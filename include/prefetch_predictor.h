@@ -0,0 +1,72 @@
+#ifndef PREFETCH_PREDICTOR_H
+#define PREFETCH_PREDICTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Chooses which pages to prerender from the reader's recent page turns.
+ *
+ * NavigationManager reports every page change with its timestamp. The
+ * direction of recent steps (newest weighted most) picks which way to look
+ * ahead, so flipping backward through a manga warms the previous pages. The
+ * pace of the turns sets how deep to go. The depth is then limited by how
+ * long a page takes to render and by how many pages fit the page cache.
+ * A page change that lands on a page from the last issued plan counts as a
+ * hit; plans the document declined to queue are not predictions.
+ * Not thread-safe; used from the UI thread only.
+ */
+class PrefetchPredictor
+{
+public:
+    struct Stats
+    {
+        uint64_t pageChanges = 0;
+        uint64_t hits = 0;   // Landed on a page from the last plan
+        uint64_t misses = 0; // Landed elsewhere while a plan was outstanding
+        int direction = 1;   // +1 forward, -1 backward
+        int depth = 0;       // Pages ahead in the last plan
+
+        double hitRate() const
+        {
+            const uint64_t planned = hits + misses;
+            return planned ? static_cast<double>(hits) / static_cast<double>(planned) : 0.0;
+        }
+    };
+
+    void recordPageChange(int fromPage, int toPage, uint32_t timestampMs);
+
+    // Pages to prerender around currentPage, most useful first. renderMs is
+    // the last measured page render time; pageBytes and cacheBudgetBytes cap
+    // the plan at what the page cache can hold next to the current page.
+    std::vector<int> plan(int currentPage, int pageCount, uint32_t renderMs, size_t pageBytes,
+                          size_t cacheBudgetBytes);
+
+    // The pages of a plan were queued; the next page change is scored against them
+    void recordIssuedPlan(const std::vector<int>& pages);
+
+    // True while pages are being turned faster than a reader would read them
+    bool isSkimming(uint32_t nowMs) const;
+
+    void reset();
+    Stats getStats() const;
+
+private:
+    struct Step
+    {
+        int delta = 0;
+        uint32_t timestampMs = 0;
+    };
+
+    int direction() const;
+    uint32_t typicalIntervalMs() const; // 0 if the reader is not turning pages steadily
+
+    std::deque<Step> m_history;
+    std::set<int> m_lastPlan;
+    Stats m_stats;
+};
+
+#endif // PREFETCH_PREDICTOR_H
@@ -85,6 +85,23 @@ public:
         m_state.lastRenderDuration = duration;
     }
 
+    // Cold page turns (page not cached): time until something is on screen and
+    // until the full-quality render replaced it
+    struct PageTurnStats
+    {
+        uint64_t coldTurns = 0;
+        uint64_t progressiveTurns = 0; // Turns that showed a low-resolution pass first
+        Uint32 lastFirstVisualMs = 0;
+        Uint32 maxFirstVisualMs = 0;
+        uint64_t firstVisualTotalMs = 0;
+        uint64_t fullQualityTurns = 0;
+        uint64_t fullQualityTotalMs = 0;
+    };
+    const PageTurnStats& getPageTurnStats() const
+    {
+        return m_pageTurnStats;
+    }
+
     // UI display timing
     void updateScaleDisplayTime()
     {
@@ -141,6 +158,7 @@ public:
         // Drop preview cache so theme changes take effect on next render
         m_lastArgbValid = false;
         m_lastArgbBuffer.reset();
+        m_lastTextureUploadId = 0;
     }
 
     // Clear cached render and dimension cache (for document load/reset)
@@ -183,15 +201,51 @@ private:
     int m_lastArgbPage = -1;
     int m_lastArgbScale = 0;
     bool m_lastArgbValid = false;
+    // Set instead of m_lastArgbBuffer when the last render went straight into the
+    // page texture; the texture then doubles as the zoom preview
+    uint64_t m_lastTextureUploadId = 0;
+    bool m_lastRenderDraft = false;       // Last render used reduced anti-aliasing
+    bool m_lastRenderProgressive = false; // Last render is a low-resolution first pass
     bool m_previewActive = false;
     bool m_showMinimap = true;
     bool m_showPageIndicatorOverlay = true;
     bool m_showScaleOverlay = true;
 
+    // Scroll position of the previous tiled frame, used to find the pan direction
+    int m_lastTileScrollX = 0;
+    int m_lastTileScrollY = 0;
+
+    // Cold page turn waiting for its full-quality render
+    int m_pendingFullPage = -1;
+    int m_pendingFullScale = 0;
+    Uint32 m_pendingFullStart = 0;
+    bool m_pendingFirstVisual = false; // Nothing of the pending page has been shown yet
+    PageTurnStats m_pageTurnStats;
+
+    // Background render of the page behind the current preview, sampled each frame
+    int m_progressPage = -1;
+    bool m_progressActive = false;
+    float m_progressFraction = -1.0f; // Negative while the amount of work is unknown
+    Uint32 m_progressElapsedMs = 0;
+
+    // Rasterize a page straight into the renderer's page texture. Returns the
+    // upload id, or 0 if the texture could not be locked.
+    uint64_t renderPageIntoTexture(MuPdfDocument* document, int page, int scale, int& width, int& height);
+
+    // Draw the visible tiles of a page at a tiled zoom level and queue the ring around them
+    bool renderTiledPage(MuPdfDocument* document, int page, int scale, ViewportManager* viewportManager,
+                         int windowWidth, int windowHeight);
+
+    // After repeated zooms in one direction, render the part of the page the
+    // next zoom step will show
+    void requestZoomIntentRender(MuPdfDocument* document, int page, ViewportManager* viewportManager,
+                                 int windowWidth, int windowHeight);
+
     // UI rendering methods
     void renderPageInfo(NavigationManager* navigationManager, ViewportManager* viewportManager, int windowWidth, int windowHeight);
     void renderScaleInfo(ViewportManager* viewportManager, int windowWidth, int windowHeight);
     void renderZoomProcessingIndicator(ViewportManager* viewportManager, int windowWidth, int windowHeight);
+    void renderPageProgressIndicator(int windowWidth, int windowHeight);
     void renderErrorMessage(int windowWidth, int windowHeight);
     void renderPageJumpInput(NavigationManager* navigationManager, int windowWidth, int windowHeight);
     void renderEdgeTurnProgressIndicator(class App* app, NavigationManager* navigationManager,
@@ -201,9 +255,10 @@ private:
                                int windowWidth, int windowHeight);
 
     // Helper methods
-    uint32_t rgb24_to_argb32(uint8_t r, uint8_t g, uint8_t b);
     void renderProgressBar(int x, int y, int width, int height, float progress, SDL_Color bgColor, SDL_Color fillColor);
-    void storeLastRender(int page, int scale, std::shared_ptr<const std::vector<uint32_t>> buffer, int width, int height);
+    void recordFirstVisual(Uint32 elapsedMs, bool progressive);
+    void storeLastRender(int page, int scale, std::shared_ptr<const std::vector<uint32_t>> buffer, int width, int height,
+                         uint64_t textureUploadId = 0);
     void renderOverlayBadge(const std::string& text, int textWidth, int textHeight,
                             float centerX, float centerY, double angleDeg,
                             SDL_Color textColor, SDL_Color bgColor, SDL_Color borderColor,
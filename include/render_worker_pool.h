@@ -0,0 +1,106 @@
+#ifndef RENDER_WORKER_POOL_H
+#define RENDER_WORKER_POOL_H
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Persistent pool of background render workers with a priority queue.
+ *
+ * Jobs are identified by a JobKey; submitting a key that is already queued or
+ * running is a no-op (a queued duplicate is raised to the higher priority).
+ * Workers start on the first submit and live until shutdown(), so page turns
+ * no longer create and join threads.
+ */
+class RenderWorkerPool
+{
+public:
+    // Lower value runs first
+    enum class Priority
+    {
+        Visible = 0,    // Page on screen at its exact scale
+        PreviewUpgrade, // Detail that replaces a scaled preview
+        Neighbor,       // Adjacent pages
+        Idle            // Bookkeeping such as page counting
+    };
+
+    struct JobKey
+    {
+        int kind = 0;
+        int page = -1;
+        int scale = 0;
+        int tileX = -1;
+        int tileY = -1;
+
+        bool operator==(const JobKey& other) const
+        {
+            return kind == other.kind && page == other.page && scale == other.scale && tileX == other.tileX &&
+                   tileY == other.tileY;
+        }
+    };
+
+    using Job = std::function<void()>;
+    using KeyPredicate = std::function<bool(const JobKey&)>;
+
+    explicit RenderWorkerPool(int workerCount = defaultWorkerCount());
+    ~RenderWorkerPool();
+
+    RenderWorkerPool(const RenderWorkerPool&) = delete;
+    RenderWorkerPool& operator=(const RenderWorkerPool&) = delete;
+
+    // Per-platform default: leave one core for the UI thread
+    static int defaultWorkerCount();
+
+    // Resize the pool. Running jobs finish first; queued jobs are kept.
+    // Must not be called from a worker.
+    void setWorkerCount(int count);
+    int getWorkerCount() const;
+
+    // Queue a job. Returns false if the key is already queued or running, or
+    // the pool has been shut down.
+    bool submit(Priority priority, const JobKey& key, Job job);
+
+    // True if a job with a matching key is queued or running
+    bool isPending(const KeyPredicate& predicate) const;
+
+    // Drop queued (not running) jobs whose key matches
+    void cancel(const KeyPredicate& predicate);
+    void cancelAll();
+
+    // Block until no matching job is queued or running
+    void wait(const KeyPredicate& predicate);
+
+    // Drop queued jobs and join the workers. Further submits are rejected.
+    void shutdown();
+
+private:
+    static constexpr size_t PRIORITY_COUNT = 4;
+
+    struct QueuedJob
+    {
+        JobKey key;
+        Job job;
+    };
+
+    void startWorkersLocked();
+    void stopWorkers(std::unique_lock<std::mutex>& lock);
+    void workerLoop();
+    bool isPendingLocked(const KeyPredicate& predicate) const;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_idleCv;
+    std::array<std::deque<QueuedJob>, PRIORITY_COUNT> m_queues;
+    std::vector<JobKey> m_running;
+    std::vector<std::thread> m_workers;
+    int m_workerCount = 1;
+    bool m_stopWorkers = false;
+    bool m_shutdown = false;
+};
+
+#endif // RENDER_WORKER_POOL_H
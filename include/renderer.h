@@ -32,30 +32,81 @@ public:
                       float destX, float destY, float destWidth, float destHeight,
                       double angleDeg, SDL_RendererFlip flip);
 
-    void renderPageExARGB(const std::vector<uint32_t>& argbData, int srcWidth, int srcHeight,
+    // The upload is skipped while the texture still holds argbData. Buffers are
+    // matched by ownership, not address: pooled buffers come back at the same
+    // address with new pixels once their last owner drops them.
+    void renderPageExARGB(const std::shared_ptr<const std::vector<uint32_t>>& argbData, int srcWidth, int srcHeight,
                           float destX, float destY, float destWidth, float destHeight,
-                          double angleDeg, SDL_RendererFlip flip, const void* bufferToken = nullptr);
+                          double angleDeg, SDL_RendererFlip flip);
+
+    // Zero-copy page upload: lock the page texture for a srcWidth x srcHeight page
+    // and hand out its pixels (pitch in bytes) so a document can rasterize straight
+    // into it. Returns nullptr on failure. A successful lock must be followed by
+    // unlockPageTexture(), which returns the upload's id (0 if nothing was written).
+    uint32_t* lockPageTexture(int srcWidth, int srcHeight, int& pitch);
+    uint64_t unlockPageTexture(bool written);
+
+    bool holdsPageUpload(uint64_t uploadId) const;
+
+    // Draw the page texture if it still holds the upload identified by uploadId.
+    // Returns false (drawing nothing) once any other upload has replaced it.
+    bool drawPageTexture(uint64_t uploadId, int srcWidth, int srcHeight,
+                         float destX, float destY, float destWidth, float destHeight,
+                         double angleDeg, SDL_RendererFlip flip);
+
+    // Draw one tile of a page. Tile textures are pooled and matched to their source
+    // buffer, so panning over tiles that are already uploaded costs no uploads.
+    void renderTileARGB(const std::shared_ptr<const std::vector<uint32_t>>& argbData, int srcWidth, int srcHeight,
+                        float destX, float destY, float destWidth, float destHeight,
+                        double angleDeg, SDL_RendererFlip flip);
 
     int getWindowWidth() const;
     int getWindowHeight() const;
 
+    // Texture format for page and tile uploads, negotiated with the SDL renderer.
+    // Always has the ARGB8888 memory layout that page buffers use.
+    Uint32 getTextureFormat() const;
+
     void toggleFullscreen();
 
     // Static method to get required SDL initialization flags
     static Uint32 getRequiredSDLInitFlags();
 
 private:
+    bool ensurePageTexture(int srcWidth, int srcHeight);
+    void copyPageTexture(int srcWidth, int srcHeight,
+                         float destX, float destY, float destWidth, float destHeight,
+                         double angleDeg, SDL_RendererFlip flip);
+
     // Now holds raw pointers as ownership is external
     SDL_Window* m_window;
     SDL_Renderer* m_renderer;
     std::unique_ptr<SDL_Texture, MySDLTextureDeleter> m_texture;
+    Uint32 m_textureFormat = SDL_PIXELFORMAT_ARGB8888;
 
     int m_currentTexWidth = 0;
     int m_currentTexHeight = 0;
     bool m_isFullscreen = false;
-    const void* m_lastBufferToken = nullptr;
+    std::weak_ptr<const std::vector<uint32_t>> m_lastBuffer; // Page buffer the texture holds
     int m_lastBufferWidth = 0;
     int m_lastBufferHeight = 0;
+    uint64_t m_pageUploadId = 0; // Bumped on every write to m_texture
+
+    struct TileTexture
+    {
+        std::unique_ptr<SDL_Texture, MySDLTextureDeleter> texture;
+        int width = 0;
+        int height = 0;
+        std::weak_ptr<const std::vector<uint32_t>> source;
+        uint64_t lastUsed = 0;
+    };
+#ifdef TRIMUI_PLATFORM
+    static constexpr size_t MAX_TILE_TEXTURES = 40;
+#else
+    static constexpr size_t MAX_TILE_TEXTURES = 48;
+#endif
+    std::vector<TileTexture> m_tileTextures;
+    uint64_t m_tileUseCounter = 0;
 };
 
 #endif // RENDERER_H
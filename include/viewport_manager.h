@@ -151,6 +151,9 @@ public:
     {
         return m_pendingZoomDelta != 0;
     }
+    // Scale of the zoom step the reader is likely to take next, or 0. Only
+    // predicted after two recent steps in the same direction.
+    int predictedNextScale() const;
 
     // Fit operations
     void fitPageToWindow(Document* document, int currentPage);
@@ -208,6 +211,7 @@ public:
     static constexpr int ZOOM_DEBOUNCE_MS = 75;
 #endif
     static constexpr int ZOOM_PROCESSING_MIN_DISPLAY_MS = 300;
+    static constexpr int ZOOM_INTENT_WINDOW_MS = 3000; // Steps further apart do not form a streak
 
 private:
     ViewportState m_state;
@@ -218,6 +222,11 @@ private:
     int m_pendingZoomDelta{0};
     std::chrono::steady_clock::time_point m_lastZoomInputTime;
 
+    // Zoom intent: consecutive applied steps in one direction (signed) and the last step
+    int m_zoomStreak{0};
+    int m_lastZoomStep{0};
+    std::chrono::steady_clock::time_point m_lastZoomAppliedTime;
+
     // Zoom processing indicator
     bool m_zoomProcessing{false};
     std::chrono::steady_clock::time_point m_zoomProcessingStartTime;
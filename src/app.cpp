@@ -1,9 +1,11 @@
 #include "app.h"
 #include "document.h"
+#include "memory_governor.h"
 #include "mupdf_document.h"
 #include "text_document.h"
 #include "navigation_manager.h"
 #include "options_manager.h"
+#include "path_utils.h"
 #include "renderer.h"
 #include "text_renderer.h"
 #ifdef TRIMUI_PLATFORM
@@ -13,9 +15,31 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
+namespace
+{
+// One rendered-page disk cache for the whole process, so its index survives
+// returning to the file browser. SDL_READER_DISK_CACHE=0 turns it off.
+std::shared_ptr<DiskPageCache> sharedDiskPageCache()
+{
+    static std::shared_ptr<DiskPageCache> cache = []() -> std::shared_ptr<DiskPageCache>
+    {
+        const char* setting = std::getenv("SDL_READER_DISK_CACHE");
+        if (setting && std::strcmp(setting, "0") == 0)
+        {
+            std::cout << "App: Disk page cache disabled by SDL_READER_DISK_CACHE" << std::endl;
+            return nullptr;
+        }
+        return std::make_shared<DiskPageCache>(getDefaultPageCacheDirectory());
+    }();
+    return cache;
+}
+} // namespace
+
 // --- App Class ---
 
 // Constructor now accepts pre-initialized SDL_Window* and SDL_Renderer*
@@ -131,7 +155,12 @@ App::App(const std::string& filename, SDL_Window* window, SDL_Renderer* renderer
         // This ensures fonts are available during initial document rendering
         if (auto muDoc = dynamic_cast<MuPdfDocument*>(m_document.get()))
         {
+            muDoc->setDiskPageCache(sharedDiskPageCache());
+
             m_optionsManager->installFontLoader(muDoc->getContext());
+            OptionsManager* optionsManager = m_optionsManager.get();
+            muDoc->setFontLoaderInstaller([optionsManager](fz_context* ctx)
+                                          { optionsManager->installFontLoader(ctx); });
 
             // Apply saved CSS configuration BEFORE opening document
             // Generate CSS even for "Document Default" to apply reading style colors
@@ -273,6 +302,8 @@ App::App(const std::string& filename, SDL_Window* window, SDL_Renderer* renderer
 
     // Now that ViewportManager has a valid renderer, do initial page load and fit
     loadDocument();
+
+    registerMemoryConsumers();
 }
 
 App::~App()
@@ -286,6 +317,8 @@ App::~App()
         std::cout.flush();
     }
 #endif
+    unregisterMemoryConsumers();
+
     // Explicitly destroy managers in controlled order to debug which one hangs
     std::cout.flush();
     m_renderManager.reset();
@@ -332,6 +365,7 @@ void App::run()
         }
 
         refreshPageCountFromDocument();
+        finishPendingRelayout();
 
         while (SDL_PollEvent(&event) != 0)
         {
@@ -361,6 +395,8 @@ void App::run()
         float dt = (now - m_prevTick) / 1000.0f;
         m_prevTick = now;
 
+        MemoryGovernor::shared().poll(now);
+
         if (!m_inFakeSleep)
         {
             // Normal rendering - only render if something changed
@@ -1161,6 +1197,19 @@ void App::refreshPageCountFromDocument()
     auto* muDoc = dynamic_cast<MuPdfDocument*>(m_document.get());
     if (muDoc && !muDoc->isPageCountFinal())
     {
+        // The chapter-by-chapter count raises the estimate as it goes
+        int partialCount = muDoc->getPageCount();
+        if (partialCount > m_navigationManager->getPageCount())
+        {
+            m_navigationManager->setPageCount(partialCount);
+            m_navigationManager->setDisplayPageCount(partialCount, true);
+            m_inputManager->setPageCount(partialCount);
+            if (m_guiManager)
+            {
+                m_guiManager->setPageCount(m_navigationManager->getDisplayPageCount(), true);
+            }
+            markDirty();
+        }
         return;
     }
 
@@ -1228,6 +1277,46 @@ void App::loadDocument()
     // m_viewportManager->clampScroll();
 }
 
+void App::finishPendingRelayout()
+{
+    auto* muDoc = dynamic_cast<MuPdfDocument*>(m_document.get());
+    int mappedPage = -1;
+    if (!muDoc || !muDoc->finishRelayout(m_navigationManager->getCurrentPage(), mappedPage))
+    {
+        return;
+    }
+
+    if (mappedPage < 0)
+    {
+        std::cout << "Failed to reopen document with new CSS" << std::endl;
+        markDirty();
+        return;
+    }
+
+    // The page number now refers to the new layout; drop the old-layout preview
+    m_renderManager->clearLastRender(nullptr);
+    m_pendingPageRestore = -1;
+
+    int pageCount = m_document->getPageCount();
+    bool isEstimated = !muDoc->isPageCountFinal() && muDoc->isPageCountEstimated();
+    m_navigationManager->setPageCount(pageCount);
+    m_navigationManager->setDisplayPageCount(pageCount, isEstimated);
+    m_inputManager->setPageCount(pageCount);
+
+    int currentPage = std::max(0, std::min(mappedPage, pageCount - 1));
+    m_navigationManager->setCurrentPage(currentPage);
+    if (m_guiManager)
+    {
+        m_guiManager->setPageCount(m_navigationManager->getDisplayPageCount(), isEstimated);
+        m_guiManager->setCurrentPage(currentPage);
+    }
+
+    m_viewportManager->clampScroll();
+    markDirty();
+
+    std::cout << "Switched to the new layout on page " << (currentPage + 1) << std::endl;
+}
+
 void App::applyPendingFontChange()
 {
     if (!m_pendingFontChange)
@@ -1335,6 +1424,37 @@ void App::applyPendingFontChange()
             // Try to cast to MuPDF document and apply CSS with safer reopening
             if (auto muDoc = dynamic_cast<MuPdfDocument*>(m_document.get()))
             {
+                uint8_t bgR, bgG, bgB;
+                OptionsManager::getReadingStyleBackgroundColor(m_pendingFontConfig.readingStyle, bgR, bgG, bgB);
+
+                // Reflowable books are laid out again on a worker; the current page
+                // stays on screen until finishPendingRelayout() switches over
+                muDoc->setBackgroundColor(bgR, bgG, bgB);
+                if (muDoc->beginRelayout(css, m_navigationManager->getCurrentPage(),
+                                         m_viewportManager->getCurrentScale()))
+                {
+                    m_renderManager->setBackgroundColor(bgR, bgG, bgB);
+                    m_optionsManager->saveConfig(m_pendingFontConfig);
+                    refreshCachedConfig();
+
+                    m_renderManager->setShowMinimap(m_cachedConfig.showDocumentMinimap);
+                    m_renderManager->setShowPageIndicatorOverlay(m_cachedConfig.showPageIndicatorOverlay);
+                    m_renderManager->setShowScaleOverlay(m_cachedConfig.showScaleOverlay);
+                    m_inputManager->setZoomStep(m_pendingFontConfig.zoomStep);
+
+                    if (m_guiManager && m_guiManager->isFontMenuVisible())
+                    {
+                        m_guiManager->toggleFontMenu();
+                    }
+                    markDirty();
+
+                    std::cout << "Applying font configuration in the background: " << m_pendingFontConfig.fontName
+                              << " at " << m_pendingFontConfig.fontSize << "pt, style: "
+                              << OptionsManager::getReadingStyleName(m_pendingFontConfig.readingStyle) << std::endl;
+                    m_pendingFontChange = false;
+                    return;
+                }
+
                 // Clear cache if font, size, or style changed (forces re-render with new styling)
                 if (fontChanged || sizeChanged || styleChanged)
                 {
@@ -1462,6 +1582,68 @@ void App::applyPendingFontChange()
 
 // ---- helpers  ----
 
+void App::registerMemoryConsumers()
+{
+    auto muDoc = dynamic_cast<MuPdfDocument*>(m_document.get());
+    if (!muDoc)
+    {
+        return;
+    }
+    MemoryGovernor& governor = MemoryGovernor::shared();
+
+    MemoryGovernor::Consumer store;
+    store.name = "MuPDF store";
+    store.shrinkOrder = 0;
+    store.usage = [muDoc]()
+    {
+        // Everything MuPDF holds that is not a display list is mostly the store
+        size_t bytes = 0;
+        for (const MuPdfAllocator::Stats& allocator : MuPdfContextPool::shared().getAllocatorStats())
+        {
+            bytes += allocator.currentBytes;
+        }
+        return bytes - std::min(bytes, muDoc->getDisplayListStats().bytes);
+    };
+    store.shed = [muDoc]()
+    { muDoc->shrinkStore(50); };
+    m_memoryConsumerIds.push_back(governor.registerConsumer(std::move(store)));
+
+    MemoryGovernor::Consumer pages;
+    pages.name = "prerendered pages";
+    pages.shrinkOrder = 1;
+    pages.share = 0.45;
+    pages.maxBytes = muDoc->getPageCacheStats().budgetBytes;
+    pages.usage = [muDoc]()
+    { return muDoc->getPageCacheStats().bytes; };
+    pages.setBudget = [muDoc](size_t bytes)
+    { muDoc->setPageCacheBudget(bytes); };
+    pages.shed = [muDoc]()
+    { muDoc->dropPrerenderedPages(); };
+    m_memoryConsumerIds.push_back(governor.registerConsumer(std::move(pages)));
+
+    MemoryGovernor::Consumer lists;
+    lists.name = "display lists";
+    lists.shrinkOrder = 3;
+    lists.share = 0.3;
+    lists.maxBytes = muDoc->getDisplayListStats().budgetBytes;
+    lists.usage = [muDoc]()
+    { return muDoc->getDisplayListStats().bytes; };
+    lists.setBudget = [muDoc](size_t bytes)
+    { muDoc->setDisplayListBudget(bytes); };
+    lists.shed = [muDoc]()
+    { muDoc->releaseDisplayLists(); };
+    m_memoryConsumerIds.push_back(governor.registerConsumer(std::move(lists)));
+}
+
+void App::unregisterMemoryConsumers()
+{
+    for (int id : m_memoryConsumerIds)
+    {
+        MemoryGovernor::shared().unregisterConsumer(id);
+    }
+    m_memoryConsumerIds.clear();
+}
+
 void App::printAppState()
 {
     std::cout << "--- App State ---" << std::endl;
@@ -1476,6 +1658,64 @@ void App::printAppState()
     {
         std::cout << "Window Dimensions: " << m_renderManager->getRenderer()->getWindowWidth() << "x" << m_renderManager->getRenderer()->getWindowHeight() << std::endl;
     }
+    if (auto muDoc = dynamic_cast<MuPdfDocument*>(m_document.get()))
+    {
+        PageCache::Stats stats = muDoc->getPageCacheStats();
+        std::cout << "Page Cache: " << stats.entries << " pages, " << (stats.bytes >> 20) << "/"
+                  << (stats.budgetBytes >> 20) << " MB, hits=" << stats.hits << " misses=" << stats.misses
+                  << " evictions=" << stats.evictions << std::endl;
+
+        MuPdfDocument::DisplayListStats listStats = muDoc->getDisplayListStats();
+        std::cout << "Display Lists: " << listStats.entries << " pages, " << (listStats.bytes >> 20) << "/"
+                  << (listStats.budgetBytes >> 20) << " MB, builds=" << listStats.builds
+                  << " evictions=" << listStats.evictions << std::endl;
+
+        MuPdfDocument::SpeculativeStats speculative = muDoc->getSpeculativeStats();
+        double speculativeHitRate = speculative.rendered
+                                        ? 100.0 * static_cast<double>(speculative.used) / static_cast<double>(speculative.rendered)
+                                        : 0.0;
+        std::cout << "Zoom Prerender: rendered=" << speculative.rendered << " used=" << speculative.used
+                  << " hit rate=" << speculativeHitRate << "%" << std::endl;
+
+        for (const MuPdfAllocator::Stats& allocator : MuPdfContextPool::shared().getAllocatorStats())
+        {
+            std::cout << "MuPDF Memory (" << allocator.name << "): " << (allocator.currentBytes >> 20) << " MB, peak "
+                      << (allocator.peakBytes >> 20) << " MB";
+            if (allocator.budgetBytes > 0)
+            {
+                std::cout << " of " << (allocator.budgetBytes >> 20) << " MB";
+            }
+            std::cout << ", allocations=" << allocator.allocations << " pooled=" << allocator.pooledAllocations
+                      << " refused=" << allocator.refused << std::endl;
+        }
+    }
+    PixelBufferPool::Stats buffers = PixelBufferPool::shared().getStats();
+    std::cout << "Pixel Buffers: reused=" << buffers.reused << "/" << buffers.acquired << " (allocations avoided)"
+              << ", idle " << buffers.idleBuffers << " = " << (buffers.idleBytes >> 20) << "/"
+              << (buffers.budgetBytes >> 20) << " MB, released=" << buffers.released << std::endl;
+    MemoryGovernor::Stats memory = MemoryGovernor::shared().getStats();
+    if (memory.memory.limitBytes > 0)
+    {
+        std::cout << "Memory: " << (memory.memory.availableBytes >> 20) << "/" << (memory.memory.limitBytes >> 20)
+                  << " MB free (" << memory.memory.source << "), RSS " << (MemoryGovernor::residentBytes() >> 20)
+                  << " MB, pressure events=" << memory.pressureEvents << " sheds=" << memory.sheds
+                  << (memory.underPressure ? " [under pressure]" : "") << std::endl;
+    }
+    if (m_renderManager)
+    {
+        const RenderManager::PageTurnStats& turns = m_renderManager->getPageTurnStats();
+        if (turns.coldTurns > 0)
+        {
+            std::cout << "Cold Page Turns: " << turns.coldTurns << " (" << turns.progressiveTurns
+                      << " progressive), first visual avg " << (turns.firstVisualTotalMs / turns.coldTurns)
+                      << " ms, max " << turns.maxFirstVisualMs << " ms, last " << turns.lastFirstVisualMs << " ms";
+            if (turns.fullQualityTurns > 0)
+            {
+                std::cout << ", full quality avg " << (turns.fullQualityTotalMs / turns.fullQualityTurns) << " ms";
+            }
+            std::cout << std::endl;
+        }
+    }
 
     // Also print navigation state
     m_navigationManager->printNavigationState();
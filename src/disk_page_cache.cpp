@@ -0,0 +1,434 @@
+#include "disk_page_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <zlib.h>
+
+namespace
+{
+#ifdef TRIMUI_PLATFORM
+constexpr uint64_t DEFAULT_DISK_CACHE_BYTES = 128ull << 20; // SD card space is shared with the library
+#else
+constexpr uint64_t DEFAULT_DISK_CACHE_BYTES = 512ull << 20;
+#endif
+
+constexpr char PAGE_FILE_MAGIC[4] = {'S', 'R', 'P', 'C'};
+constexpr uint32_t PAGE_FILE_VERSION = 1;
+constexpr const char* PAGE_FILE_EXTENSION = ".page";
+constexpr int MAX_PAGE_DIMENSION = 16384;
+
+struct PageFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    uint32_t keyLength;
+    uint32_t reserved;
+    uint64_t compressedBytes;
+};
+
+uint64_t fnv1a64(const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Page images are mostly long runs of background, which run-length matching at
+// the fastest level handles well for a fraction of the default level's time.
+bool compressPixels(const uint32_t* pixels, size_t byteCount, std::vector<unsigned char>& out)
+{
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15, 8, Z_RLE) != Z_OK)
+    {
+        return false;
+    }
+
+    out.resize(deflateBound(&stream, static_cast<uLong>(byteCount)));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<uint32_t*>(pixels));
+    stream.avail_in = static_cast<uInt>(byteCount);
+    stream.next_out = out.data();
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    const int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+bool decompressPixels(const std::vector<unsigned char>& compressed, uint32_t* pixels, size_t byteCount)
+{
+    uLongf destLength = static_cast<uLongf>(byteCount);
+    const int result = uncompress(reinterpret_cast<Bytef*>(pixels), &destLength, compressed.data(),
+                                  static_cast<uLong>(compressed.size()));
+    return result == Z_OK && destLength == byteCount;
+}
+} // namespace
+
+DiskPageCache::DiskPageCache(std::filesystem::path directory, uint64_t budgetBytes)
+    : m_directory(std::move(directory)), m_budgetBytes(budgetBytes)
+{
+}
+
+DiskPageCache::~DiskPageCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_stopWriter = true;
+    }
+    m_writeCv.notify_all();
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+}
+
+uint64_t DiskPageCache::defaultBudgetBytes()
+{
+    return DEFAULT_DISK_CACHE_BYTES;
+}
+
+std::string DiskPageCache::documentIdentity(const std::string& path)
+{
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec)
+    {
+        return std::string();
+    }
+    const auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec)
+    {
+        return std::string();
+    }
+
+    return path + "|" + std::to_string(size) + "|" + std::to_string(modified.time_since_epoch().count());
+}
+
+std::string DiskPageCache::keyText(const Key& key)
+{
+    return key.document + "\n" + key.variant + "\n" + std::to_string(key.page) + "\n" + std::to_string(key.scale);
+}
+
+std::string DiskPageCache::fileNameFor(const std::string& text)
+{
+    static const char* HEX = "0123456789abcdef";
+    uint64_t hash = fnv1a64(text);
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; --i)
+    {
+        name[static_cast<size_t>(i)] = HEX[hash & 0xF];
+        hash >>= 4;
+    }
+    return name + PAGE_FILE_EXTENSION;
+}
+
+bool DiskPageCache::contains(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ensureIndexLocked();
+    return m_index.find(fileNameFor(keyText(key))) != m_index.end();
+}
+
+bool DiskPageCache::load(const Key& key, std::vector<uint32_t>& pixels, int& width, int& height)
+{
+    const std::string text = keyText(key);
+    const std::string name = fileNameFor(text);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ensureIndexLocked();
+        auto it = m_index.find(name);
+        if (it == m_index.end())
+        {
+            ++m_misses;
+            return false;
+        }
+        it->second.lastUse = ++m_useCounter;
+    }
+
+    const std::filesystem::path path = m_directory / name;
+    bool ok = false;
+    {
+        std::ifstream file(path, std::ios::binary);
+        PageFileHeader header{};
+        std::string storedKey;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+            std::memcmp(header.magic, PAGE_FILE_MAGIC, sizeof(PAGE_FILE_MAGIC)) == 0 &&
+            header.version == PAGE_FILE_VERSION && header.width > 0 && header.height > 0 &&
+            header.width <= MAX_PAGE_DIMENSION && header.height <= MAX_PAGE_DIMENSION &&
+            header.keyLength == text.size())
+        {
+            storedKey.resize(header.keyLength);
+            file.read(&storedKey[0], static_cast<std::streamsize>(storedKey.size()));
+        }
+
+        // A different key under the same name is a hash collision; treat it as a miss
+        if (file && storedKey == text)
+        {
+            std::vector<unsigned char> compressed(static_cast<size_t>(header.compressedBytes));
+            if (file.read(reinterpret_cast<char*>(compressed.data()), static_cast<std::streamsize>(compressed.size())))
+            {
+                const size_t pixelCount = static_cast<size_t>(header.width) * static_cast<size_t>(header.height);
+                pixels.resize(pixelCount);
+                if (decompressPixels(compressed, pixels.data(), pixelCount * sizeof(uint32_t)))
+                {
+                    width = header.width;
+                    height = header.height;
+                    ok = true;
+                }
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!ok)
+    {
+        ++m_misses;
+        auto it = m_index.find(name);
+        if (it != m_index.end())
+        {
+            removeLocked(it);
+        }
+        return false;
+    }
+
+    ++m_hits;
+    // Carry the recency over to the next session
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void DiskPageCache::store(const Key& key, const uint32_t* pixels, int width, int height)
+{
+    if (!pixels || width <= 0 || height <= 0 || width > MAX_PAGE_DIMENSION || height > MAX_PAGE_DIMENSION)
+    {
+        return;
+    }
+
+    const std::string text = keyText(key);
+    const std::string name = fileNameFor(text);
+
+    std::vector<unsigned char> compressed;
+    const size_t byteCount = static_cast<size_t>(width) * static_cast<size_t>(height) * sizeof(uint32_t);
+    if (!compressPixels(pixels, byteCount, compressed))
+    {
+        std::cerr << "DiskPageCache: Failed to compress page " << key.page << std::endl;
+        return;
+    }
+
+    PageFileHeader header{};
+    std::memcpy(header.magic, PAGE_FILE_MAGIC, sizeof(PAGE_FILE_MAGIC));
+    header.version = PAGE_FILE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.keyLength = static_cast<uint32_t>(text.size());
+    header.compressedBytes = compressed.size();
+
+    uint64_t tempId = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ensureIndexLocked();
+        tempId = ++m_useCounter;
+    }
+
+    // Write under a temporary name and rename, so readers never see half a file
+    const std::filesystem::path path = m_directory / name;
+    const std::filesystem::path tempPath = m_directory / (name + ".tmp" + std::to_string(tempId));
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        file.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+        if (!file)
+        {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            std::cerr << "DiskPageCache: Failed to write " << tempPath << std::endl;
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return;
+    }
+
+    const uint64_t fileBytes = sizeof(header) + text.size() + compressed.size();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    IndexEntry& entry = m_index[name];
+    m_bytes -= entry.bytes;
+    entry.bytes = fileBytes;
+    entry.lastUse = ++m_useCounter;
+    m_bytes += fileBytes;
+    ++m_writes;
+    trimLocked(name);
+}
+
+void DiskPageCache::storeAsync(const Key& key, PixelBufferPtr pixels, int width, int height)
+{
+    if (!pixels || pixels->size() < static_cast<size_t>(std::max(width, 0)) * static_cast<size_t>(std::max(height, 0)))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        if (m_stopWriter)
+        {
+            return;
+        }
+
+        const std::string text = keyText(key);
+        m_pendingWrites.erase(std::remove_if(m_pendingWrites.begin(), m_pendingWrites.end(),
+                                             [&text](const PendingWrite& pending)
+                                             { return keyText(pending.key) == text; }),
+                              m_pendingWrites.end());
+        if (m_pendingWrites.size() >= MAX_PENDING_WRITES)
+        {
+            m_pendingWrites.pop_front();
+        }
+        m_pendingWrites.push_back(PendingWrite{key, std::move(pixels), width, height});
+
+        if (!m_writer.joinable())
+        {
+            m_writer = std::thread(&DiskPageCache::writerLoop, this);
+        }
+    }
+    m_writeCv.notify_one();
+}
+
+void DiskPageCache::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+    while (true)
+    {
+        m_writeCv.wait(lock, [this]()
+                       { return m_stopWriter || !m_pendingWrites.empty(); });
+        if (m_pendingWrites.empty())
+        {
+            return; // Stopping with nothing left to write
+        }
+
+        PendingWrite pending = std::move(m_pendingWrites.front());
+        m_pendingWrites.pop_front();
+        lock.unlock();
+
+        store(pending.key, pending.pixels->data(), pending.width, pending.height);
+        pending.pixels.reset();
+
+        lock.lock();
+    }
+}
+
+DiskPageCache::Stats DiskPageCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.writes = m_writes;
+    stats.evictions = m_evictions;
+    stats.entries = m_index.size();
+    stats.bytes = m_bytes;
+    stats.budgetBytes = m_budgetBytes;
+    return stats;
+}
+
+void DiskPageCache::ensureIndexLocked()
+{
+    if (m_indexLoaded)
+    {
+        return;
+    }
+    m_indexLoaded = true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    struct Found
+    {
+        std::string name;
+        uint64_t bytes;
+        std::filesystem::file_time_type modified;
+    };
+    std::vector<Found> found;
+
+    for (std::filesystem::directory_iterator it(m_directory, ec), end; !ec && it != end; it.increment(ec))
+    {
+        const std::filesystem::path& path = it->path();
+        const std::string name = path.filename().string();
+        if (name.find(".tmp") != std::string::npos)
+        {
+            // Left behind by a write that never finished
+            std::error_code removeEc;
+            std::filesystem::remove(path, removeEc);
+            continue;
+        }
+        if (path.extension() != PAGE_FILE_EXTENSION)
+        {
+            continue;
+        }
+
+        std::error_code statEc;
+        const uint64_t bytes = it->file_size(statEc);
+        const auto modified = it->last_write_time(statEc);
+        if (!statEc)
+        {
+            found.push_back(Found{name, bytes, modified});
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b)
+              { return a.modified < b.modified; });
+    for (const auto& file : found)
+    {
+        m_index[file.name] = IndexEntry{file.bytes, ++m_useCounter};
+        m_bytes += file.bytes;
+    }
+
+    trimLocked(std::string());
+}
+
+void DiskPageCache::trimLocked(const std::string& keep)
+{
+    while (m_bytes > m_budgetBytes && m_index.size() > 1)
+    {
+        auto oldest = m_index.end();
+        for (auto it = m_index.begin(); it != m_index.end(); ++it)
+        {
+            if (it->first != keep && (oldest == m_index.end() || it->second.lastUse < oldest->second.lastUse))
+            {
+                oldest = it;
+            }
+        }
+        if (oldest == m_index.end())
+        {
+            break;
+        }
+        removeLocked(oldest);
+        ++m_evictions;
+    }
+}
+
+void DiskPageCache::removeLocked(std::map<std::string, IndexEntry>::iterator it)
+{
+    std::error_code ec;
+    std::filesystem::remove(m_directory / it->first, ec);
+    m_bytes -= std::min(m_bytes, it->second.bytes);
+    m_index.erase(it);
+}
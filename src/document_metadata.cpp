@@ -0,0 +1,149 @@
+#include "document_metadata.h"
+#include "path_utils.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+constexpr char METADATA_MAGIC[4] = {'S', 'R', 'M', 'D'};
+constexpr uint32_t METADATA_VERSION = 1;
+constexpr uint32_t MAX_METADATA_PAGES = 1u << 20;
+
+struct MetadataHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t keyLength;
+    int32_t pageCount;
+    uint32_t boundsCount;
+    uint32_t reserved;
+};
+
+std::string metadataKey(const std::string& documentIdentity, const std::string& css)
+{
+    return documentIdentity + "\n" + css;
+}
+
+std::filesystem::path sidecarPath(const std::string& key, const char* extension)
+{
+    static const char* HEX = "0123456789abcdef";
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; --i)
+    {
+        name[static_cast<size_t>(i)] = HEX[hash & 0xF];
+        hash >>= 4;
+    }
+    return getDefaultMetadataDirectory() / (name + extension);
+}
+} // namespace
+
+bool loadDocumentMetadata(const std::string& documentIdentity, const std::string& css, DocumentMetadata& metadata)
+{
+    if (documentIdentity.empty())
+    {
+        return false;
+    }
+
+    const std::string key = metadataKey(documentIdentity, css);
+    std::ifstream file(sidecarPath(key, ".meta"), std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    MetadataHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, METADATA_MAGIC, sizeof(METADATA_MAGIC)) != 0 ||
+        header.version != METADATA_VERSION || header.keyLength != key.size() || header.pageCount < 0 ||
+        header.boundsCount > MAX_METADATA_PAGES)
+    {
+        return false;
+    }
+
+    std::string storedKey(header.keyLength, '\0');
+    if (!file.read(&storedKey[0], static_cast<std::streamsize>(storedKey.size())) || storedKey != key)
+    {
+        return false;
+    }
+
+    std::vector<DocumentMetadata::PageBounds> bounds(header.boundsCount);
+    if (!bounds.empty() &&
+        !file.read(reinterpret_cast<char*>(bounds.data()),
+                   static_cast<std::streamsize>(bounds.size() * sizeof(DocumentMetadata::PageBounds))))
+    {
+        return false;
+    }
+
+    metadata.pageCount = header.pageCount;
+    metadata.bounds = std::move(bounds);
+    return true;
+}
+
+bool saveDocumentMetadata(const std::string& documentIdentity, const std::string& css,
+                          const DocumentMetadata& metadata)
+{
+    if (documentIdentity.empty())
+    {
+        return false;
+    }
+
+    const std::string key = metadataKey(documentIdentity, css);
+    const std::filesystem::path path = sidecarPath(key, ".meta");
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    MetadataHeader header{};
+    std::memcpy(header.magic, METADATA_MAGIC, sizeof(METADATA_MAGIC));
+    header.version = METADATA_VERSION;
+    header.keyLength = static_cast<uint32_t>(key.size());
+    header.pageCount = metadata.pageCount;
+    header.boundsCount = static_cast<uint32_t>(metadata.bounds.size());
+
+    // Write under a temporary name and rename so a crash never leaves half a file
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(key.data(), static_cast<std::streamsize>(key.size()));
+        file.write(reinterpret_cast<const char*>(metadata.bounds.data()),
+                   static_cast<std::streamsize>(metadata.bounds.size() * sizeof(DocumentMetadata::PageBounds)));
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(tempPath, ec);
+            std::cerr << "Failed to write document metadata: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::filesystem::path documentAcceleratorPath(const std::string& documentIdentity, const std::string& css)
+{
+    if (documentIdentity.empty())
+    {
+        return {};
+    }
+    return sidecarPath(metadataKey(documentIdentity, css), ".accel");
+}
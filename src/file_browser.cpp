@@ -1,6 +1,9 @@
 #include "file_browser.h"
+#include "memory_governor.h"
 #include "options_manager.h"
 #include "path_utils.h"
+#include "pixel_convert.h"
+#include "mupdf_allocator.h"
 #include "mupdf_locking.h"
 
 #ifndef NK_INCLUDE_FIXED_TYPES
@@ -156,7 +159,7 @@ class QuickThumbnailRenderer
 public:
     QuickThumbnailRenderer()
     {
-        m_ctx = fz_new_context(nullptr, getSharedMuPdfLocks(), 64 << 20);
+        m_ctx = fz_new_context(m_allocator.allocContext(), getSharedMuPdfLocks(), 64 << 20);
         if (!m_ctx)
         {
             throw std::runtime_error("Failed to create MuPDF context for thumbnails");
@@ -178,6 +181,7 @@ public:
         if (m_ctx)
         {
             fz_drop_context(m_ctx);
+            std::cout << "QuickThumbnailRenderer: " << m_allocator.describe() << std::endl;
         }
     }
 
@@ -232,16 +236,8 @@ public:
 
             for (int y = 0; y < height; ++y)
             {
-                const unsigned char* row = samples + static_cast<size_t>(y) * stride;
-                for (int x = 0; x < width; ++x)
-                {
-                    const unsigned char* src = row + static_cast<size_t>(x) * 4;
-                    uint32_t r = src[0];
-                    uint32_t g = src[1];
-                    uint32_t b = src[2];
-                    uint32_t a = src[3];
-                    pixels[static_cast<size_t>(y) * width + x] = (a << 24) | (r << 16) | (g << 8) | b;
-                }
+                pixel_convert::rgbaToArgb(samples + static_cast<size_t>(y) * stride,
+                                          pixels.data() + static_cast<size_t>(y) * width, static_cast<size_t>(width));
             }
         }
         fz_always(m_ctx)
@@ -272,6 +268,7 @@ public:
     }
 
 private:
+    MuPdfAllocator m_allocator{"MuPDF thumbnails"}; // Declared first: must outlive m_ctx
     fz_context* m_ctx{nullptr};
 };
 
@@ -303,10 +300,31 @@ FileBrowser::FileBrowser()
       m_dpadUpHeld(false), m_dpadDownHeld(false), m_lastScrollTime(0), m_waitingForInitialRepeat(false),
       m_leftHeld(false), m_rightHeld(false), m_lastHorizontalScrollTime(0), m_waitingForInitialHorizontalRepeat(false)
 {
+    // Thumbnails go after the reader's prerendered pages but before display lists
+    MemoryGovernor::Consumer thumbnails;
+    thumbnails.name = "thumbnails";
+    thumbnails.shrinkOrder = 2;
+    thumbnails.share = 0.1;
+    thumbnails.maxBytes = MAX_CACHED_THUMBNAILS * THUMBNAIL_MAX_DIM * THUMBNAIL_MAX_DIM * 4;
+    thumbnails.usage = [this]()
+    { return thumbnailBytes(); };
+    thumbnails.setBudget = [this](size_t bytes)
+    {
+        const size_t perThumbnail = static_cast<size_t>(THUMBNAIL_MAX_DIM) * THUMBNAIL_MAX_DIM * 4;
+        m_maxCachedThumbnails = std::clamp(bytes / perThumbnail, MIN_CACHED_THUMBNAILS, MAX_CACHED_THUMBNAILS);
+        evictOldThumbnails();
+    };
+    thumbnails.shed = [this]()
+    {
+        m_maxCachedThumbnails = std::max(MIN_CACHED_THUMBNAILS, m_thumbnailUsage.size() / 2);
+        evictOldThumbnails();
+    };
+    m_memoryConsumerId = MemoryGovernor::shared().registerConsumer(std::move(thumbnails));
 }
 
 FileBrowser::~FileBrowser()
 {
+    MemoryGovernor::shared().unregisterConsumer(m_memoryConsumerId);
     cleanup(false);
     clearThumbnailCache();
     s_lastThumbnailView = m_thumbnailView;
@@ -1077,13 +1095,26 @@ void FileBrowser::recordThumbnailUsage(const std::string& path)
 
 void FileBrowser::evictOldThumbnails()
 {
-    while (m_thumbnailUsage.size() > MAX_CACHED_THUMBNAILS)
+    while (m_thumbnailUsage.size() > m_maxCachedThumbnails)
     {
         const std::string victimPath = m_thumbnailUsage.back();
         removeThumbnailEntry(victimPath);
     }
 }
 
+size_t FileBrowser::thumbnailBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& [path, data] : m_thumbnailCache)
+    {
+        if (data.texture)
+        {
+            bytes += static_cast<size_t>(data.width) * static_cast<size_t>(data.height) * 4;
+        }
+    }
+    return bytes;
+}
+
 void FileBrowser::enqueueThumbnailJob(const FileEntry& entry)
 {
     if (entry.isDirectory)
@@ -1155,7 +1186,7 @@ void FileBrowser::pumpThumbnailResults()
             continue;
         }
 
-        SDL_Texture* texture = createTextureFromPixels(result.pixels, result.width, result.height);
+        SDL_Texture* texture = createTextureFromPixels(*result.pixels, result.width, result.height);
         if (!texture)
         {
             data.failed = true;
@@ -1194,10 +1225,12 @@ void FileBrowser::thumbnailWorkerLoop()
 
         if (!job.isDirectory)
         {
-            std::vector<uint32_t> pixels;
+            // Sized for the largest thumbnail, so rendering only shrinks it
+            PixelBufferPool::BufferPtr pixels = PixelBufferPool::shared().acquire(
+                static_cast<size_t>(THUMBNAIL_MAX_DIM) * static_cast<size_t>(THUMBNAIL_MAX_DIM));
             int width = 0;
             int height = 0;
-            if (buildDocumentThumbnailPixels(job, pixels, width, height))
+            if (buildDocumentThumbnailPixels(job, *pixels, width, height))
             {
                 result.success = true;
                 result.width = width;
@@ -2030,6 +2063,8 @@ std::string FileBrowser::run()
         render();
 #endif
 
+        MemoryGovernor::shared().poll(SDL_GetTicks());
+
         // Small delay to prevent CPU spinning
         SDL_Delay(10);
     }
@@ -0,0 +1,309 @@
+#include "memory_governor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+constexpr double USABLE_FRACTION = 0.5; // Of free memory plus what the caches hold; the rest is for everything else
+constexpr uint64_t MIN_FREE_BYTES = 48ull << 20;
+constexpr uint64_t PRESSURE_FREE_DIVISOR = 20; // Under pressure below 5% of the limit free
+constexpr size_t MIN_BUDGET_BYTES = 4u << 20;
+constexpr double REBUDGET_TOLERANCE = 0.1; // Ignore budget changes smaller than this
+constexpr uint64_t UNLIMITED_CGROUP_BYTES = 1ull << 60; // cgroup v1 reports "no limit" as a huge number
+
+// Single number from a sysfs/procfs file; false for "max" or an unreadable file
+bool readNumber(const char* path, uint64_t& value)
+{
+    std::ifstream file(path);
+    std::string text;
+    if (!(file >> text) || text == "max")
+    {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtoull(text.c_str(), &end, 10);
+    return end && *end == '\0';
+}
+
+// Value of a "name value" line, as found in /proc/meminfo and memory.stat
+bool readField(const char* path, const std::string& name, uint64_t& value)
+{
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string field;
+        if (fields >> field && field == name)
+        {
+            return static_cast<bool>(fields >> value);
+        }
+    }
+    return false;
+}
+
+// Limit and free bytes of a cgroup. Inactive file pages count as free: the
+// kernel reclaims them before it reaches for the OOM killer.
+bool readCgroup(const char* limitPath, const char* usagePath, const char* statPath, const char* inactiveField,
+                uint64_t& limit, uint64_t& available)
+{
+    uint64_t usage = 0;
+    if (!readNumber(limitPath, limit) || limit >= UNLIMITED_CGROUP_BYTES || !readNumber(usagePath, usage))
+    {
+        return false;
+    }
+    uint64_t inactive = 0;
+    if (readField(statPath, inactiveField, inactive))
+    {
+        usage -= std::min(usage, inactive);
+    }
+    available = limit > usage ? limit - usage : 0;
+    return true;
+}
+
+uint64_t toMegabytes(uint64_t bytes)
+{
+    return bytes >> 20;
+}
+} // namespace
+
+MemoryGovernor& MemoryGovernor::shared()
+{
+    // Never destroyed: documents may unregister during static destruction
+    static MemoryGovernor* governor = new MemoryGovernor();
+    return *governor;
+}
+
+int MemoryGovernor::registerConsumer(Consumer consumer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Registration registration;
+    registration.id = m_nextId++;
+    registration.consumer = std::move(consumer);
+    auto position = std::upper_bound(m_consumers.begin(), m_consumers.end(), registration.consumer.shrinkOrder,
+                                     [](int order, const Registration& other)
+                                     { return order < other.consumer.shrinkOrder; });
+    m_consumers.insert(position, std::move(registration));
+    m_stats.consumers = m_consumers.size();
+    // Budget the newcomer on the next call
+    m_polled = false;
+    return m_nextId - 1;
+}
+
+void MemoryGovernor::unregisterConsumer(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_consumers.erase(std::remove_if(m_consumers.begin(), m_consumers.end(),
+                                     [id](const Registration& registration)
+                                     { return registration.id == id; }),
+                      m_consumers.end());
+    m_stats.consumers = m_consumers.size();
+    m_shedLevel = 0;
+}
+
+void MemoryGovernor::poll(uint32_t nowMs)
+{
+    std::vector<Registration> consumers;
+    std::function<Snapshot()> source;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const uint32_t interval = m_stats.underPressure ? PRESSURE_POLL_INTERVAL_MS : POLL_INTERVAL_MS;
+        if (m_polled && nowMs - m_lastPollMs < interval)
+        {
+            return;
+        }
+        m_polled = true;
+        m_lastPollMs = nowMs;
+        consumers = m_consumers;
+        source = m_memorySource;
+    }
+    if (consumers.empty())
+    {
+        return;
+    }
+
+    const Snapshot memory = source ? source() : readMemory();
+    if (memory.limitBytes == 0)
+    {
+        return; // Nothing to go on; the consumers keep their defaults
+    }
+
+    uint64_t cached = 0;
+    for (const Registration& registration : consumers)
+    {
+        if (registration.consumer.usage)
+        {
+            cached += registration.consumer.usage();
+        }
+    }
+
+    // Budgets follow what is free now, counting memory the caches already
+    // hold as theirs to keep
+    const double usable = static_cast<double>(memory.availableBytes + cached) * USABLE_FRACTION;
+    for (Registration& registration : consumers)
+    {
+        const Consumer& consumer = registration.consumer;
+        if (consumer.share <= 0.0 || !consumer.setBudget)
+        {
+            continue;
+        }
+        size_t budget = std::max(MIN_BUDGET_BYTES, static_cast<size_t>(usable * consumer.share));
+        if (consumer.maxBytes > 0)
+        {
+            budget = std::min(budget, consumer.maxBytes);
+        }
+        const double change = registration.appliedBudget
+                                  ? std::abs(static_cast<double>(budget) - static_cast<double>(registration.appliedBudget)) /
+                                        static_cast<double>(registration.appliedBudget)
+                                  : 1.0;
+        if (change > REBUDGET_TOLERANCE)
+        {
+            if (registration.appliedBudget)
+            {
+                std::cout << "MemoryGovernor: " << consumer.name << " budget " << toMegabytes(budget) << " MB ("
+                          << toMegabytes(memory.availableBytes) << " MB free)" << std::endl;
+            }
+            consumer.setBudget(budget);
+            registration.appliedBudget = budget;
+        }
+    }
+
+    const uint64_t pressureFloor = std::max(MIN_FREE_BYTES, memory.limitBytes / PRESSURE_FREE_DIVISOR);
+    const bool pressure = memory.availableBytes < pressureFloor;
+
+    Consumer victim;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const Registration& polled : consumers)
+        {
+            for (Registration& registration : m_consumers)
+            {
+                if (registration.id == polled.id)
+                {
+                    registration.appliedBudget = polled.appliedBudget;
+                }
+            }
+        }
+        m_stats.memory = memory;
+
+        if (pressure && !m_consumers.empty())
+        {
+            if (!m_stats.underPressure)
+            {
+                ++m_stats.pressureEvents;
+                m_shedLevel = 0;
+            }
+            // One more consumer each poll; after the last, start over
+            victim = m_consumers[m_shedLevel % m_consumers.size()].consumer;
+            ++m_shedLevel;
+            ++m_stats.sheds;
+        }
+        else if (!pressure && m_stats.underPressure)
+        {
+            std::cout << "MemoryGovernor: Memory pressure over (" << toMegabytes(memory.availableBytes)
+                      << " MB free), restoring budgets" << std::endl;
+            m_shedLevel = 0;
+            // Shedding may have cut below the budgets; hand them out again
+            for (Registration& registration : m_consumers)
+            {
+                registration.appliedBudget = 0;
+            }
+            m_polled = false;
+        }
+        m_stats.underPressure = pressure;
+    }
+
+    if (victim.shed)
+    {
+        std::cout << "MemoryGovernor: Low memory (" << toMegabytes(memory.availableBytes) << " of "
+                  << toMegabytes(memory.limitBytes) << " MB free, " << memory.source << "), shedding "
+                  << victim.name << std::endl;
+        victim.shed();
+    }
+}
+
+MemoryGovernor::Snapshot MemoryGovernor::readMemory() const
+{
+    Snapshot snapshot;
+    auto consider = [&snapshot](uint64_t limit, uint64_t available, const char* source)
+    {
+        if (snapshot.limitBytes == 0 || limit < snapshot.limitBytes)
+        {
+            snapshot.limitBytes = limit;
+        }
+        if (snapshot.source.empty() || available < snapshot.availableBytes)
+        {
+            snapshot.availableBytes = available;
+            snapshot.source = source;
+        }
+    };
+
+    uint64_t totalKb = 0;
+    uint64_t availableKb = 0;
+    if (readField("/proc/meminfo", "MemTotal:", totalKb))
+    {
+        if (!readField("/proc/meminfo", "MemAvailable:", availableKb))
+        {
+            // Kernels before 3.14 lack MemAvailable
+            uint64_t freeKb = 0;
+            uint64_t cachedKb = 0;
+            readField("/proc/meminfo", "MemFree:", freeKb);
+            readField("/proc/meminfo", "Cached:", cachedKb);
+            availableKb = freeKb + cachedKb;
+        }
+        consider(totalKb << 10, availableKb << 10, "meminfo");
+    }
+
+    uint64_t limit = 0;
+    uint64_t available = 0;
+    if (readCgroup("/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory.current", "/sys/fs/cgroup/memory.stat",
+                   "inactive_file", limit, available))
+    {
+        consider(limit, available, "cgroup v2");
+    }
+    else if (readCgroup("/sys/fs/cgroup/memory/memory.limit_in_bytes", "/sys/fs/cgroup/memory/memory.usage_in_bytes",
+                        "/sys/fs/cgroup/memory/memory.stat", "total_inactive_file", limit, available))
+    {
+        consider(limit, available, "cgroup v1");
+    }
+
+    const char* setting = std::getenv("SDL_READER_MEMORY_LIMIT_MB");
+    if (setting && std::atoi(setting) > 0)
+    {
+        limit = static_cast<uint64_t>(std::atoi(setting)) << 20;
+        const uint64_t resident = residentBytes();
+        consider(limit, limit > resident ? limit - resident : 0, "SDL_READER_MEMORY_LIMIT_MB");
+    }
+    return snapshot;
+}
+
+void MemoryGovernor::setMemorySource(std::function<Snapshot()> source)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_memorySource = std::move(source);
+    m_polled = false;
+}
+
+MemoryGovernor::Stats MemoryGovernor::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+uint64_t MemoryGovernor::residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t totalPages = 0;
+    uint64_t residentPages = 0;
+    if (!(statm >> totalPages >> residentPages))
+    {
+        return 0;
+    }
+    return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
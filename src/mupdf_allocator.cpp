@@ -0,0 +1,292 @@
+#include "mupdf_allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+constexpr uint32_t LARGE_BLOCK = 0xFFFFFFFFu;
+
+thread_local int64_t t_netBytes = 0;
+
+// Sits in front of every block; 16 bytes keeps the payload aligned like malloc's
+struct alignas(16) BlockHeader
+{
+    size_t size;        // Requested bytes
+    uint32_t sizeClass; // Free list index, or LARGE_BLOCK for malloc'd blocks
+    uint32_t reserved;
+};
+static_assert(sizeof(BlockHeader) == 16, "BlockHeader must keep 16-byte payload alignment");
+
+constexpr size_t classPayloadBytes(size_t sizeClass)
+{
+    return size_t{16} << sizeClass;
+}
+
+size_t sizeClassFor(size_t size)
+{
+    size_t sizeClass = 0;
+    while (classPayloadBytes(sizeClass) < size)
+    {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+BlockHeader* headerOf(void* ptr)
+{
+    return reinterpret_cast<BlockHeader*>(static_cast<unsigned char*>(ptr) - sizeof(BlockHeader));
+}
+} // namespace
+
+MuPdfAllocator::MuPdfAllocator(std::string name, size_t budgetBytes)
+    : m_name(std::move(name)), m_allocContext{this, allocCallback, reallocCallback, freeCallback},
+      m_budgetBytes(budgetBytes)
+{
+}
+
+MuPdfAllocator::~MuPdfAllocator()
+{
+    for (void* slab : m_slabs)
+    {
+        std::free(slab);
+    }
+}
+
+void MuPdfAllocator::setBudget(size_t bytes)
+{
+    m_budgetBytes.store(bytes);
+}
+
+MuPdfAllocator::Stats MuPdfAllocator::getStats() const
+{
+    Stats stats;
+    stats.name = m_name;
+    stats.currentBytes = m_currentBytes.load();
+    stats.peakBytes = m_peakBytes.load();
+    stats.budgetBytes = m_budgetBytes.load();
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        stats.slabBytes = m_slabs.size() * SLAB_BYTES;
+    }
+    stats.allocations = m_allocations.load();
+    stats.pooledAllocations = m_pooledAllocations.load();
+    stats.refused = m_refused.load();
+    return stats;
+}
+
+std::string MuPdfAllocator::describe() const
+{
+    Stats stats = getStats();
+    std::ostringstream out;
+    out << stats.name << ": " << (stats.currentBytes >> 10) << "/" << (stats.peakBytes >> 10) << " KB current/peak";
+    if (stats.budgetBytes > 0)
+    {
+        out << " of " << (stats.budgetBytes >> 10) << " KB";
+    }
+    out << ", " << stats.allocations << " allocations (" << stats.pooledAllocations << " pooled, "
+        << (stats.slabBytes >> 10) << " KB slabs), " << stats.refused << " refused";
+    return out.str();
+}
+
+int64_t MuPdfAllocator::threadNetBytes()
+{
+    return t_netBytes;
+}
+
+void* MuPdfAllocator::allocCallback(void* user, size_t size)
+{
+    return static_cast<MuPdfAllocator*>(user)->allocate(size);
+}
+
+void* MuPdfAllocator::reallocCallback(void* user, void* old, size_t size)
+{
+    return static_cast<MuPdfAllocator*>(user)->reallocate(old, size);
+}
+
+void MuPdfAllocator::freeCallback(void* user, void* ptr)
+{
+    static_cast<MuPdfAllocator*>(user)->release(ptr);
+}
+
+bool MuPdfAllocator::reserve(size_t size)
+{
+    const size_t budget = m_budgetBytes.load();
+    size_t current = m_currentBytes.load();
+    do
+    {
+        if (budget > 0 && current + size > budget)
+        {
+            // MuPDF scavenges its store on failure and asks again
+            m_refused.fetch_add(1);
+            return false;
+        }
+    } while (!m_currentBytes.compare_exchange_weak(current, current + size));
+
+    size_t peak = m_peakBytes.load();
+    while (current + size > peak && !m_peakBytes.compare_exchange_weak(peak, current + size))
+    {
+    }
+    t_netBytes += static_cast<int64_t>(size);
+    return true;
+}
+
+void MuPdfAllocator::unreserve(size_t size)
+{
+    m_currentBytes.fetch_sub(size);
+    t_netBytes -= static_cast<int64_t>(size);
+}
+
+void* MuPdfAllocator::allocatePooled(size_t sizeClass)
+{
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    if (FreeBlock* block = m_freeLists[sizeClass])
+    {
+        m_freeLists[sizeClass] = block->next;
+        return block;
+    }
+
+    const size_t blockBytes = sizeof(BlockHeader) + classPayloadBytes(sizeClass);
+    if (m_slabRemaining[sizeClass] < blockBytes)
+    {
+        void* slab = std::malloc(SLAB_BYTES);
+        if (!slab)
+        {
+            return nullptr;
+        }
+        m_slabs.push_back(slab);
+        m_slabCursor[sizeClass] = static_cast<unsigned char*>(slab);
+        m_slabRemaining[sizeClass] = SLAB_BYTES;
+    }
+
+    void* block = m_slabCursor[sizeClass];
+    m_slabCursor[sizeClass] += blockBytes;
+    m_slabRemaining[sizeClass] -= blockBytes;
+    return block;
+}
+
+void* MuPdfAllocator::allocate(size_t size)
+{
+    if (!reserve(size))
+    {
+        return nullptr;
+    }
+
+    void* raw = nullptr;
+    uint32_t sizeClass = LARGE_BLOCK;
+    if (size <= MAX_POOLED_BYTES)
+    {
+        sizeClass = static_cast<uint32_t>(sizeClassFor(size));
+        raw = allocatePooled(sizeClass);
+    }
+    else
+    {
+        raw = std::malloc(sizeof(BlockHeader) + size);
+    }
+
+    if (!raw)
+    {
+        unreserve(size);
+        return nullptr;
+    }
+
+    m_allocations.fetch_add(1);
+    if (sizeClass != LARGE_BLOCK)
+    {
+        m_pooledAllocations.fetch_add(1);
+    }
+    auto* header = static_cast<BlockHeader*>(raw);
+    header->size = size;
+    header->sizeClass = sizeClass;
+    header->reserved = 0;
+    return header + 1;
+}
+
+void* MuPdfAllocator::reallocate(void* old, size_t size)
+{
+    if (!old)
+    {
+        return allocate(size);
+    }
+    if (size == 0)
+    {
+        release(old);
+        return nullptr;
+    }
+
+    BlockHeader* header = headerOf(old);
+    const size_t oldSize = header->size;
+
+    // Still fits the block it has: only the accounting changes
+    if (header->sizeClass != LARGE_BLOCK && size <= classPayloadBytes(header->sizeClass) &&
+        sizeClassFor(size) == header->sizeClass)
+    {
+        if (size > oldSize && !reserve(size - oldSize))
+        {
+            return nullptr;
+        }
+        if (size < oldSize)
+        {
+            unreserve(oldSize - size);
+        }
+        header->size = size;
+        return old;
+    }
+
+    if (header->sizeClass == LARGE_BLOCK && size > MAX_POOLED_BYTES)
+    {
+        if (size > oldSize && !reserve(size - oldSize))
+        {
+            return nullptr;
+        }
+        auto* grown = static_cast<BlockHeader*>(std::realloc(header, sizeof(BlockHeader) + size));
+        if (!grown)
+        {
+            if (size > oldSize)
+            {
+                unreserve(size - oldSize);
+            }
+            return nullptr;
+        }
+        if (size < oldSize)
+        {
+            unreserve(oldSize - size);
+        }
+        grown->size = size;
+        return grown + 1;
+    }
+
+    // Crossing between pooled and malloc'd blocks
+    void* moved = allocate(size);
+    if (!moved)
+    {
+        return nullptr;
+    }
+    std::memcpy(moved, old, std::min(oldSize, size));
+    release(old);
+    return moved;
+}
+
+void MuPdfAllocator::release(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    BlockHeader* header = headerOf(ptr);
+    unreserve(header->size);
+    if (header->sizeClass == LARGE_BLOCK)
+    {
+        std::free(header);
+        return;
+    }
+
+    const uint32_t sizeClass = header->sizeClass;
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    auto* block = reinterpret_cast<FreeBlock*>(header);
+    block->next = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = block;
+}
@@ -0,0 +1,115 @@
+#include "mupdf_context_pool.h"
+#include "mupdf_locking.h"
+
+#include <iostream>
+#include <string>
+
+namespace
+{
+constexpr int DEFAULT_AA_BITS = 8;
+} // namespace
+
+MuPdfContextPool& MuPdfContextPool::shared()
+{
+    // Never destroyed: the contexts outlive static destruction order
+    static MuPdfContextPool* pool = new MuPdfContextPool();
+    return *pool;
+}
+
+fz_context* MuPdfContextPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_idle.empty())
+        {
+            fz_context* ctx = m_idle.back();
+            m_idle.pop_back();
+            ++m_reused;
+            return ctx;
+        }
+    }
+
+    // Numbered when reserved, so concurrent creators never share a name
+    size_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        index = m_nextIndex++;
+    }
+    auto allocator = std::make_unique<MuPdfAllocator>("MuPDF context " + std::to_string(index), ALLOCATION_BUDGET_BYTES);
+    fz_context* ctx = fz_new_context(allocator->allocContext(), getSharedMuPdfLocks(), STORE_BYTES);
+    if (!ctx)
+    {
+        std::cerr << "MuPdfContextPool: Cannot create MuPDF context" << std::endl;
+        return nullptr;
+    }
+
+    fz_try(ctx)
+    {
+        fz_register_document_handlers(ctx);
+    }
+    fz_catch(ctx)
+    {
+        std::cerr << "MuPdfContextPool: Failed to register document handlers: " << fz_caught_message(ctx) << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocators.push_back(std::move(allocator));
+    ++m_created;
+    return ctx;
+}
+
+void MuPdfContextPool::release(fz_context* ctx)
+{
+    if (!ctx)
+    {
+        return;
+    }
+
+    // Forget everything the last document left behind, including the system
+    // font loader the reader installs for its font choices
+    fz_try(ctx)
+    {
+        fz_empty_store(ctx);
+        fz_set_user_css(ctx, nullptr);
+        fz_set_aa_level(ctx, DEFAULT_AA_BITS);
+        fz_install_load_system_font_funcs(ctx, nullptr, nullptr, nullptr);
+    }
+    fz_catch(ctx)
+    {
+        std::cerr << "MuPdfContextPool: Failed to reset context: " << fz_caught_message(ctx) << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.push_back(ctx);
+}
+
+std::vector<MuPdfAllocator::Stats> MuPdfContextPool::getAllocatorStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<MuPdfAllocator::Stats> stats;
+    stats.reserve(m_allocators.size());
+    for (const auto& allocator : m_allocators)
+    {
+        stats.push_back(allocator->getStats());
+    }
+    return stats;
+}
+
+void MuPdfContextPool::logAllocatorStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& allocator : m_allocators)
+    {
+        std::cout << "MuPdfContextPool: " << allocator->describe() << std::endl;
+    }
+}
+
+MuPdfContextPool::Stats MuPdfContextPool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.created = m_created;
+    stats.reused = m_reused;
+    stats.idle = m_idle.size();
+    return stats;
+}
@@ -1,5 +1,8 @@
 #include "mupdf_document.h"
+#include "document_metadata.h"
+#include "mupdf_allocator.h"
 #include "mupdf_locking.h"
+#include "pixel_convert.h"
 
 #include <algorithm>
 #include <cctype>
@@ -10,6 +13,7 @@
 #include <stdexcept>
 #include <cstdlib>
 #include <chrono>
+#include <condition_variable>
 
 struct MuPdfDocument::PageScaleInfo
 {
@@ -25,13 +29,314 @@ struct MuPdfDocument::PageScaleInfo
 
 namespace
 {
+#ifdef TRIMUI_PLATFORM
+constexpr int MAX_RASTER_BANDS = 4; // One per A53 core
+#else
+constexpr int MAX_RASTER_BANDS = 8;
+#endif
+constexpr int MIN_RASTER_BAND_ROWS = 128;
+// Below this, handing the bands out costs more than it saves. Kept above one
+// tile, so tiles are drawn whole and in parallel with each other instead.
+constexpr size_t MIN_BANDED_RASTER_PIXELS = 4 * MuPdfDocument::TILE_SIZE * MuPdfDocument::TILE_SIZE;
+constexpr auto BAND_ABORT_POLL_INTERVAL = std::chrono::milliseconds(5);
+constexpr long long SLOW_RASTER_LOG_MS = 150;
+
+// RenderWorkerPool job kinds
+constexpr int JOB_PAGE_RENDER = 1;
+constexpr int JOB_TILE_RENDER = 2;
+constexpr int JOB_PRERENDER = 3;
+constexpr int JOB_PAGE_COUNT = 4;
+constexpr int JOB_RELAYOUT = 5;
+constexpr int JOB_SPECULATIVE = 6;
+constexpr int JOB_RASTER_BAND = 7; // m_bandPool only
+constexpr int JOB_PAGE_PREVIEW = 8;
+
+constexpr size_t MAX_TRACKED_SPECULATIVE = 64;
+
+// Anti-aliasing bits for draft renders while the reader is zooming or flipping
+constexpr int DRAFT_TEXT_AA_BITS = 2;
+constexpr int DRAFT_GRAPHICS_AA_BITS = 0;
+
+#ifdef TRIMUI_PLATFORM
+constexpr size_t DEFAULT_DISPLAY_LIST_BUDGET = 32u << 20;
+#else
+constexpr size_t DEFAULT_DISPLAY_LIST_BUDGET = 128u << 20;
+#endif
+constexpr int PINNED_DISPLAY_LIST_RADIUS = 2; // Pages either side of the current one
+
+// Floor for a display list's accounted size: an empty list still costs its
+// header and a node block
+constexpr size_t MIN_DISPLAY_LIST_BYTES = 256;
+
+// How long the chapter-by-chapter page count backs off while a visible page renders
+constexpr auto PAGE_COUNT_YIELD_INTERVAL = std::chrono::milliseconds(4);
+
+bool isJobKind(const RenderWorkerPool::JobKey& key, int kind)
+{
+    return key.kind == kind;
+}
+
+int maxRasterBands()
+{
+    const unsigned int cores = std::thread::hardware_concurrency();
+    return std::min<int>(MAX_RASTER_BANDS, cores == 0 ? 1 : static_cast<int>(cores));
+}
+
+bool isForegroundRenderJob(const RenderWorkerPool::JobKey& key)
+{
+    return key.kind == JOB_PAGE_RENDER || key.kind == JOB_TILE_RENDER || key.kind == JOB_PAGE_PREVIEW;
+}
+
+// Jobs that put rendered pixels into the page cache
+bool isRasterJob(const RenderWorkerPool::JobKey& key)
+{
+    return key.kind == JOB_PAGE_RENDER || key.kind == JOB_TILE_RENDER || key.kind == JOB_PRERENDER ||
+           key.kind == JOB_SPECULATIVE || key.kind == JOB_PAGE_PREVIEW;
+}
+
+// Counts a synchronous render for the lifetime of the scope
+class ForegroundRenderScope
+{
+public:
+    explicit ForegroundRenderScope(std::atomic<int>& counter)
+        : m_counter(counter)
+    {
+        m_counter.fetch_add(1);
+    }
+    ~ForegroundRenderScope()
+    {
+        m_counter.fetch_sub(1);
+    }
+
+    ForegroundRenderScope(const ForegroundRenderScope&) = delete;
+    ForegroundRenderScope& operator=(const ForegroundRenderScope&) = delete;
+
+private:
+    std::atomic<int>& m_counter;
+};
+
+// Lowers a context's anti-aliasing for the lifetime of the scope
+class ScopedDraftAntialias
+{
+public:
+    ScopedDraftAntialias(fz_context* ctx, bool draft)
+        : m_ctx(draft ? ctx : nullptr)
+    {
+        if (m_ctx)
+        {
+            m_textBits = fz_text_aa_level(m_ctx);
+            m_graphicsBits = fz_graphics_aa_level(m_ctx);
+            fz_set_text_aa_level(m_ctx, DRAFT_TEXT_AA_BITS);
+            fz_set_graphics_aa_level(m_ctx, DRAFT_GRAPHICS_AA_BITS);
+        }
+    }
+    ~ScopedDraftAntialias()
+    {
+        if (m_ctx)
+        {
+            fz_set_text_aa_level(m_ctx, m_textBits);
+            fz_set_graphics_aa_level(m_ctx, m_graphicsBits);
+        }
+    }
+
+    ScopedDraftAntialias(const ScopedDraftAntialias&) = delete;
+    ScopedDraftAntialias& operator=(const ScopedDraftAntialias&) = delete;
+
+private:
+    fz_context* m_ctx;
+    int m_textBits = 8;
+    int m_graphicsBits = 8;
+};
+
+// Open a document, reusing a saved layout accelerator when one exists so
+// reflowable books skip the chapter layout pass. A broken accelerator is
+// deleted and the document is opened normally. Throws through fz_throw.
+fz_document* openDocumentAccelerated(fz_context* ctx, const std::string& path, const std::string& accelerator)
+{
+    std::error_code ec;
+    if (!accelerator.empty() && std::filesystem::exists(accelerator, ec))
+    {
+        fz_document* doc = nullptr;
+        fz_var(doc);
+        fz_try(ctx)
+        {
+            doc = fz_open_accelerated_document(ctx, path.c_str(), accelerator.c_str());
+        }
+        fz_catch(ctx)
+        {
+            std::cerr << "MuPdfDocument: Discarding unusable accelerator " << accelerator << ": "
+                      << fz_caught_message(ctx) << std::endl;
+            std::filesystem::remove(accelerator, ec);
+            doc = nullptr;
+        }
+        if (doc)
+        {
+            return doc;
+        }
+    }
+    return fz_open_document(ctx, path.c_str());
+}
+
+// Save the accelerator of a fully laid out document under a temporary name
+// and rename it into place
+void saveDocumentAccelerator(fz_context* ctx, fz_document* doc, const std::string& accelerator)
+{
+    std::error_code ec;
+    if (accelerator.empty() || !fz_document_supports_accelerator(ctx, doc))
+    {
+        return;
+    }
+
+    std::filesystem::path target(accelerator);
+    std::filesystem::create_directories(target.parent_path(), ec);
+    std::filesystem::path tempPath = target;
+    tempPath += ".tmp";
+
+    bool saved = false;
+    fz_var(saved);
+    fz_try(ctx)
+    {
+        fz_save_accelerator(ctx, doc, tempPath.string().c_str());
+        saved = true;
+    }
+    fz_catch(ctx)
+    {
+        std::cerr << "MuPdfDocument: Failed to save accelerator: " << fz_caught_message(ctx) << std::endl;
+    }
+
+    if (saved)
+    {
+        std::filesystem::rename(tempPath, target, ec);
+    }
+    if (!saved || ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+// MuPDF stores a BGR pixmap with alpha as B,G,R,A bytes, which is exactly an
+// ARGB8888 word on little-endian hosts. There we let MuPDF draw straight into
+// the page buffer; big-endian hosts (Wii U) render RGBA and repack.
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+constexpr bool BGRA_PIXMAP_IS_ARGB32 = true;
+#else
+constexpr bool BGRA_PIXMAP_IS_ARGB32 = false;
+#endif
+
+// Pixmap covering rect whose samples end up as ARGB words in dest, rows
+// destStride pixels apart. Throws through fz_throw.
+fz_pixmap* newArgbTargetPixmap(fz_context* ctx, const fz_irect& rect, uint32_t* dest, int destStride)
+{
+    if (BGRA_PIXMAP_IS_ARGB32)
+    {
+        fz_pixmap* pix = fz_new_pixmap_with_data(ctx, fz_device_bgr(ctx), rect.x1 - rect.x0, rect.y1 - rect.y0,
+                                                 nullptr, 1, destStride * 4, reinterpret_cast<unsigned char*>(dest));
+        pix->x = rect.x0;
+        pix->y = rect.y0;
+        return pix;
+    }
+    return fz_new_pixmap_with_bbox(ctx, fz_device_rgb(ctx), rect, nullptr, 1);
+}
+
+// Complete a pixmap from newArgbTargetPixmap: a no-op when MuPDF already drew
+// into dest, otherwise repack its RGBA samples into ARGB words.
+void finishArgbTargetPixmap(fz_context* ctx, fz_pixmap* pix, uint32_t* dest, int destStride)
+{
+    if (BGRA_PIXMAP_IS_ARGB32)
+    {
+        return;
+    }
+
+    const int width = fz_pixmap_width(ctx, pix);
+    const int height = fz_pixmap_height(ctx, pix);
+    const unsigned char* samples = fz_pixmap_samples(ctx, pix);
+    const int stride = fz_pixmap_stride(ctx, pix);
+    if (!samples || stride < width * 4)
+    {
+        fz_throw(ctx, FZ_ERROR_GENERIC, "Invalid pixmap data (samples=%p, stride=%d, width=%d)",
+                 static_cast<const void*>(samples), stride, width);
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        pixel_convert::rgbaToArgb(samples + static_cast<size_t>(y) * stride,
+                                  dest + static_cast<size_t>(y) * destStride, static_cast<size_t>(width));
+    }
+}
+
+// Rasterize one horizontal band of a display list and write it as ARGB into
+// destRows (the band's first row in the page buffer, rows destStride pixels
+// apart). Runs on its own context, so it never throws; failures are reported
+// through error.
+bool rasterizeBandARGB(fz_context* ctx, fz_display_list* list, const fz_matrix& transform, const fz_irect& band,
+                       unsigned char clearValue, uint32_t* destRows, int destWidth, int destStride,
+                       fz_cookie* cookie, std::string& error)
+{
+    fz_pixmap* pix = nullptr;
+    fz_device* dev = nullptr;
+    fz_var(pix);
+    fz_var(dev);
+    bool ok = true;
+
+    fz_try(ctx)
+    {
+        if (band.x1 - band.x0 != destWidth)
+        {
+            fz_throw(ctx, FZ_ERROR_GENERIC, "Band width %d does not match page width %d", band.x1 - band.x0,
+                     destWidth);
+        }
+        pix = newArgbTargetPixmap(ctx, band, destRows, destStride);
+        fz_clear_pixmap_with_value(ctx, pix, clearValue);
+
+        dev = fz_new_draw_device(ctx, fz_identity, pix);
+        // Clip rectangle must be in device space, otherwise high zoom levels clip content.
+        fz_run_display_list(ctx, list, dev, transform, fz_rect_from_irect(band), cookie);
+        fz_close_device(ctx, dev);
+        if (cookie && cookie->abort)
+        {
+            fz_throw(ctx, FZ_ERROR_GENERIC, "Render aborted");
+        }
+
+        finishArgbTargetPixmap(ctx, pix, destRows, destStride);
+    }
+    fz_always(ctx)
+    {
+        fz_drop_device(ctx, dev);
+        fz_drop_pixmap(ctx, pix);
+    }
+    fz_catch(ctx)
+    {
+        const char* muErr = fz_caught_message(ctx);
+        error = (muErr && *muErr) ? muErr : "unknown MuPDF error";
+        ok = false;
+    }
+
+    return ok;
+}
+
+// MuPDF updates a cookie's progress fields as plain stores on the render
+// thread. Other threads read them with relaxed atomic loads, so each value
+// is read whole, though progress and progress_max may come from slightly
+// different moments.
+template <typename T>
+T loadCookieField(const T& field)
+{
+    return __atomic_load_n(&field, __ATOMIC_RELAXED);
+}
+
+template <typename T>
+void storeCookieField(T& field, T value)
+{
+    __atomic_store_n(&field, value, __ATOMIC_RELAXED);
+}
 } // namespace
 
 MuPdfDocument::MuPdfDocument()
-    : Document()
+    : Document(), m_displayListBudget(DEFAULT_DISPLAY_LIST_BUDGET)
 {
-    // Initialize MuPDF context with limited store size to prevent corruption
-    m_ctx = std::unique_ptr<fz_context, ContextDeleter>(fz_new_context(nullptr, getSharedMuPdfLocks(), 256 << 20)); // 256MB
+    m_ctx = std::unique_ptr<fz_context, ContextDeleter>(MuPdfContextPool::shared().acquire());
+    // Workers start with the first banded page
+    m_bandPool.setWorkerCount(maxRasterBands());
 }
 
 MuPdfDocument::~MuPdfDocument()
@@ -40,25 +345,18 @@ MuPdfDocument::~MuPdfDocument()
 
     m_asyncShutdown = true;
     cancelPrerendering();
-    stopPageCountThread();
-    joinAsyncRenderThread();
+    m_renderPool.shutdown();
+    saveMetadata();
 
+    m_pageCache.clear();
+
+    // Browse mode creates a document per book, so everything is released here
+    // rather than left for process exit
     {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-        m_cache.clear();
-        m_argbCache.clear();
-        m_dimensionCache.clear();
+        std::lock_guard<std::mutex> relayoutLock(m_relayoutMutex);
+        discardRelayoutDocument(m_relayout);
     }
-
-    resetDisplayCache();
-
-    // Allow process teardown to leak MuPDF allocations instead of risking double-free during shutdown.
-    // These contexts/documents live for the process lifetime; skipping destruction here avoids crashes
-    // observed in macOS malloc guard.
-    m_doc.release();
-    m_prerenderDoc.release();
-    m_ctx.release();
-    m_prerenderCtx.release();
+    releaseMuPdfResources();
 
     std::cout.flush();
 }
@@ -73,6 +371,7 @@ bool MuPdfDocument::open(const std::string& filePath)
 bool MuPdfDocument::open(const std::string& filePath, bool reuseContexts)
 {
     stopPageCountThread();
+    saveMetadata();
 
     if (!reuseContexts)
     {
@@ -82,7 +381,6 @@ bool MuPdfDocument::open(const std::string& filePath, bool reuseContexts)
     {
         // Only close documents, keep contexts
         m_doc.reset();
-        m_prerenderDoc.reset();
     }
 
     // Store file path for potential reopening
@@ -111,14 +409,13 @@ bool MuPdfDocument::open(const std::string& filePath, bool reuseContexts)
     fz_context* ctx = nullptr;
     if (!reuseContexts || !m_ctx)
     {
-        ctx = fz_new_context(nullptr, getSharedMuPdfLocks(), 256 << 20); // 256MB
+        ctx = MuPdfContextPool::shared().acquire();
         if (!ctx)
         {
             std::cerr << "Cannot create MuPDF context\n";
             return false;
         }
         m_ctx.reset(ctx);
-        fz_register_document_handlers(ctx);
     }
     else
     {
@@ -139,44 +436,25 @@ bool MuPdfDocument::open(const std::string& filePath, bool reuseContexts)
         }
     }
 
-    // Create separate context for prerendering to avoid race conditions
-    fz_context* prerenderCtx = nullptr;
-    fz_var(prerenderCtx);
-    if (!reuseContexts || !m_prerenderCtx)
-    {
-        prerenderCtx = fz_new_context(nullptr, getSharedMuPdfLocks(), 256 << 20); // 256MB
-        if (!prerenderCtx)
-        {
-            std::cerr << "Cannot create prerender MuPDF context\n";
-            return false;
-        }
-        m_prerenderCtx.reset(prerenderCtx);
-        fz_register_document_handlers(prerenderCtx);
-    }
-    else
-    {
-        prerenderCtx = m_prerenderCtx.get();
-    }
-
-    // Apply user CSS to prerender context as well
-    if (!m_userCSS.empty())
+    m_documentIdentity = DiskPageCache::documentIdentity(filePath);
+    m_metadataCss = m_userCSS;
+    m_acceleratorPath.clear();
+    if (m_isReflowableDocument)
     {
-        fz_try(prerenderCtx)
-        {
-            fz_set_user_css(prerenderCtx, m_userCSS.c_str());
-        }
-        fz_catch(prerenderCtx)
-        {
-            std::cerr << "Failed to set user CSS in prerender context: " << fz_caught_message(prerenderCtx) << std::endl;
-        }
+        // Pagination depends on the CSS, so the accelerator is keyed by it too
+        m_acceleratorPath = documentAcceleratorPath(m_documentIdentity, m_metadataCss).string();
     }
 
+    // The document is parsed once. Background work uses contexts cloned from
+    // ctx (shared store and locks) and takes m_renderMutex around every call
+    // into the document, since MuPDF documents are single-threaded.
+    const auto openStart = std::chrono::steady_clock::now();
     fz_document* doc = nullptr;
     fz_var(doc);
 
     fz_try(ctx)
     {
-        doc = fz_open_document(ctx, filePath.c_str());
+        doc = openDocumentAccelerated(ctx, filePath, m_acceleratorPath);
     }
     fz_catch(ctx)
     {
@@ -192,28 +470,60 @@ bool MuPdfDocument::open(const std::string& filePath, bool reuseContexts)
 
     m_doc = std::unique_ptr<fz_document, DocumentDeleter>(doc, DocumentDeleter{ctx});
 
-    // Also open document in prerender context
-    fz_document* prerenderDocPtr = nullptr;
-    fz_var(prerenderDocPtr);
+    loadLayoutState();
 
-    fz_try(prerenderCtx)
-    {
-        prerenderDocPtr = fz_open_document(prerenderCtx, filePath.c_str());
-    }
-    fz_catch(prerenderCtx)
+    std::cout << "MuPdfDocument: Opened " << std::filesystem::path(filePath).filename().string() << " in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - openStart).count()
+              << " ms" << std::endl;
+
+    m_asyncShutdown = false;
+    resetDisplayCache();
+
+    m_pageCache.clear();
+
+    if (m_isReflowableDocument && !m_pageCountFinal.load())
     {
-        std::cerr << "Failed to open document in prerender context: " << filePath << "\n";
-        return false;
+        startAsyncPageCount();
     }
 
-    m_prerenderDoc = std::unique_ptr<fz_document, DocumentDeleter>(prerenderDocPtr, DocumentDeleter{prerenderCtx});
+    return true;
+}
 
+void MuPdfDocument::loadLayoutState()
+{
     m_pageCountFinal.store(false);
-    m_pageCountThreadActive.store(false);
     m_pageCountEstimated.store(false);
+    m_pageCountCounted.store(false);
+
+    DocumentMetadata metadata;
+    if (!loadDocumentMetadata(m_documentIdentity, m_metadataCss, metadata))
+    {
+        metadata = DocumentMetadata();
+    }
+    {
+        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+        m_knownPageBounds.assign(metadata.bounds.size(), fz_empty_rect);
+        for (size_t i = 0; i < metadata.bounds.size(); ++i)
+        {
+            const auto& known = metadata.bounds[i];
+            if (known.known())
+            {
+                m_knownPageBounds[i] = fz_make_rect(known.x0, known.y0, known.x1, known.y1);
+            }
+        }
+    }
+    m_metadataDirty.store(false);
 
     int initialPageCount = 0;
-    if (m_isReflowableDocument)
+    if (m_isReflowableDocument && metadata.pageCount > 0)
+    {
+        // Counted on an earlier open with the same CSS; no relayout needed
+        initialPageCount = metadata.pageCount;
+        m_pageCountFinal.store(true);
+        m_pageCountCounted.store(true);
+        std::cout << "MuPdfDocument: Page count " << initialPageCount << " from metadata sidecar" << std::endl;
+    }
+    else if (m_isReflowableDocument)
     {
         // Estimate page count for reflowable formats (EPUB/MOBI) using file size to avoid blocking UI.
         // Different base estimates to account for compression and layout density.
@@ -221,7 +531,7 @@ bool MuPdfDocument::open(const std::string& filePath, bool reuseContexts)
 
         try
         {
-            auto fileSize = std::filesystem::file_size(filePath);
+            auto fileSize = std::filesystem::file_size(m_filePath);
             initialPageCount = std::max(1, static_cast<int>((fileSize + bytesPerPage - 1) / bytesPerPage));
             // Small buffer to avoid underestimation
             initialPageCount = static_cast<int>(initialPageCount * 1.1);
@@ -235,28 +545,13 @@ bool MuPdfDocument::open(const std::string& filePath, bool reuseContexts)
     }
     else
     {
-        initialPageCount = fz_count_pages(ctx, doc);
+        initialPageCount = fz_count_pages(m_ctx.get(), m_doc.get());
         m_pageCountFinal.store(true);
         m_pageCountEstimated.store(false);
+        m_pageCountCounted.store(true);
     }
 
     m_pageCount.store(initialPageCount);
-
-    m_asyncShutdown = false;
-    resetDisplayCache();
-
-    {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        m_cache.clear();
-        m_argbCache.clear();
-    }
-
-    if (m_isReflowableDocument)
-    {
-        startAsyncPageCount();
-    }
-
-    return true;
 }
 
 void MuPdfDocument::ensurePageCountAtLeast(int minCount)
@@ -280,147 +575,233 @@ void MuPdfDocument::ensurePageCountAtLeast(int minCount)
 
 void MuPdfDocument::startAsyncPageCount()
 {
-    if (m_pageCountThreadActive.load())
-    {
-        return;
-    }
-
-    if (m_pageCountThread.joinable())
-    {
-        m_pageCountThread.join();
-    }
-
     if (m_asyncShutdown.load())
     {
         return;
     }
 
-    m_pageCountThreadActive.store(true);
-    m_pageCountThread = std::thread([this]()
-                                    {
+    RenderWorkerPool::JobKey key;
+    key.kind = JOB_PAGE_COUNT;
+    m_renderPool.submit(RenderWorkerPool::Priority::Idle, key, [this]()
+                        {
         if (m_asyncShutdown.load())
         {
-            m_pageCountThreadActive.store(false);
             return;
         }
 
-        std::string path = m_filePath;
-        if (path.empty())
+        // Lay the open document out on a clone of the main context. The clone
+        // shares the user CSS, so the count matches the rendered pages, and the
+        // layouts it produces are the ones the foreground pages are drawn from.
+        std::string accelerator = m_acceleratorPath;
+        fz_context* countCtx = nullptr;
         {
-            m_pageCountThreadActive.store(false);
-            return;
+            std::lock_guard<std::mutex> renderLock(m_renderMutex);
+            if (!m_ctx || !m_doc)
+            {
+                return;
+            }
+            countCtx = fz_clone_context(m_ctx.get());
         }
-
-        // Capture the current user CSS so the async page count uses the same
-        // styling as the main rendering context.  Without this, reflowable
-        // documents (EPUB/MOBI) would be laid out with MuPDF defaults and the
-        // resulting page count would not match the actual rendered pages.
-        std::string css = m_userCSS;
-
-        int resolvedCount = 0;
-        fz_context* localCtx = fz_new_context(nullptr, getSharedMuPdfLocks(), 64 << 20);
-        if (!localCtx)
+        if (!countCtx)
         {
-            m_pageCountThreadActive.store(false);
+            std::cerr << "Async page count: failed to clone context" << std::endl;
             return;
         }
-        fz_register_document_handlers(localCtx);
 
-        // Apply user CSS to the local context so fz_count_pages() lays out
-        // the document with the same font size / margins as the main context.
-        if (!css.empty())
-        {
-            fz_try(localCtx)
-            {
-                fz_set_user_css(localCtx, css.c_str());
-            }
-            fz_catch(localCtx)
-            {
-                // Non-fatal: proceed with default styling
-                std::cerr << "Async page count: failed to set user CSS" << std::endl;
-            }
-        }
+        int resolvedCount = countPagesByChapter(countCtx);
 
-        fz_document* localDoc = nullptr;
-        fz_var(localDoc);
-        fz_var(resolvedCount);
-        fz_try(localCtx)
+        // Counting laid out every chapter; keep that work for the next open
+        if (resolvedCount > 0)
         {
-            localDoc = fz_open_document(localCtx, path.c_str());
-            resolvedCount = fz_count_pages(localCtx, localDoc);
-        }
-        fz_catch(localCtx)
-        {
-            const char* msg = fz_caught_message(localCtx);
-            if (msg && std::strlen(msg) > 0)
+            std::lock_guard<std::mutex> renderLock(m_renderMutex);
+            if (m_doc)
             {
-                std::cerr << "Async page count failed: " << msg << std::endl;
+                saveDocumentAccelerator(countCtx, m_doc.get(), accelerator);
             }
         }
 
+        fz_drop_context(countCtx);
+
         if (resolvedCount > 0 && !m_asyncShutdown.load())
         {
+            m_pageCountCounted.store(true);
             finalizePageCount(resolvedCount);
-        }
-
-        m_pageCountThreadActive.store(false); });
+            saveMetadata();
+        } });
 }
 
 void MuPdfDocument::stopPageCountThread()
 {
-    if (m_pageCountThread.joinable())
-    {
-        m_pageCountThreadActive.store(false);
-        m_pageCountThread.join();
-    }
+    // A running count stops at the next chapter boundary
+    auto isPageCount = [](const RenderWorkerPool::JobKey& key)
+    { return isJobKind(key, JOB_PAGE_COUNT); };
+    m_pageCountAbort.store(true);
+    m_renderPool.cancel(isPageCount);
+    m_renderPool.wait(isPageCount);
+    m_pageCountAbort.store(false);
 }
 
-void MuPdfDocument::finalizePageCount(int newCount)
+int MuPdfDocument::countPagesByChapter(fz_context* ctx)
 {
-    int clamped = std::max(newCount, 1);
-    m_pageCount.store(clamped);
+    auto start = std::chrono::steady_clock::now();
+    int chapters = 0;
+    int focusChapter = -1;
+    int pagesBeforeFocus = 0; // Pages ahead of focusChapter
+    int counted = 0;
+    fz_var(chapters);
+    fz_var(focusChapter);
+    fz_var(pagesBeforeFocus);
+    {
+        std::lock_guard<std::mutex> renderLock(m_renderMutex);
+        if (!m_doc)
+        {
+            return 0;
+        }
+        fz_try(ctx)
+        {
+            chapters = fz_count_chapters(ctx, m_doc.get());
+        }
+        fz_catch(ctx)
+        {
+            std::cerr << "Async page count failed: " << fz_caught_message(ctx) << std::endl;
+            return 0;
+        }
 
-    {
-        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
-        if (static_cast<int>(m_pageDisplayData.size()) < clamped)
+        // The reader's page has been loaded by now, so the chapters up to it
+        // are laid out and finding its chapter costs nothing
+        const int focus = m_focusPage.load();
+        fz_try(ctx)
         {
-            m_pageDisplayData.resize(static_cast<size_t>(clamped));
+            fz_location location = fz_location_from_page_number(ctx, m_doc.get(), std::max(focus, 0));
+            if (location.chapter >= 0 && location.chapter < chapters)
+            {
+                focusChapter = location.chapter;
+                pagesBeforeFocus = focus - location.page;
+            }
+        }
+        fz_catch(ctx)
+        {
+            focusChapter = -1;
         }
     }
 
-    m_pageCountFinal.store(true);
-    m_pageCountEstimated.store(false);
-}
-
-bool MuPdfDocument::reopenWithCSS(const std::string& css)
-{
-    if (m_filePath.empty())
+    // The chapter being read first, so paging through it is never held up by
+    // the ones after it, then the rest in order
+    std::vector<int> order;
+    order.reserve(static_cast<size_t>(std::max(chapters, 0)));
+    if (focusChapter >= 0)
     {
-        std::cerr << "Cannot reopen document: no file path stored" << std::endl;
-        return false;
+        order.push_back(focusChapter);
+    }
+    for (int chapter = 0; chapter < chapters; ++chapter)
+    {
+        if (chapter != focusChapter)
+        {
+            order.push_back(chapter);
+        }
     }
 
-    std::cout << "Reopening document with new CSS: " << css << std::endl;
+    int knownPages = 0; // Lower bound on the page count so far
+    for (int chapter : order)
+    {
+        // Lay out one chapter at a time and step aside while a visible page is
+        // being rendered, so the count only uses otherwise idle time
+        while (!m_pageCountAbort.load() &&
+               (m_renderPool.isPending(isForegroundRenderJob) || m_foregroundRenders.load() > 0))
+        {
+            std::this_thread::sleep_for(PAGE_COUNT_YIELD_INTERVAL);
+        }
+        if (m_pageCountAbort.load() || m_asyncShutdown.load())
+        {
+            return 0;
+        }
+
+        // The document is shared with the renderer, so one chapter is laid
+        // out per lock
+        int chapterPages = 0;
+        fz_var(chapterPages);
+        {
+            std::lock_guard<std::mutex> renderLock(m_renderMutex);
+            if (!m_doc)
+            {
+                return 0;
+            }
+            fz_try(ctx)
+            {
+                chapterPages = fz_count_chapter_pages(ctx, m_doc.get(), chapter);
+            }
+            fz_catch(ctx)
+            {
+                std::cerr << "Async page count failed: " << fz_caught_message(ctx) << std::endl;
+                return 0;
+            }
+        }
+        counted += chapterPages;
+        if (chapter == focusChapter)
+        {
+            // Everything up to the end of the reader's chapter exists
+            knownPages = pagesBeforeFocus + chapterPages;
+        }
+        knownPages = std::max(knownPages, counted);
+
+        // Publish the partial count: the estimate only ever grows past it, so
+        // navigation opens up as chapters are counted
+        ensurePageCountAtLeast(knownPages);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "MuPdfDocument: Counted " << counted << " pages in " << chapters << " chapters ("
+              << elapsed.count() << " ms)" << std::endl;
+    return counted;
+}
+
+void MuPdfDocument::finalizePageCount(int newCount)
+{
+    int clamped = std::max(newCount, 1);
+    m_pageCount.store(clamped);
+
+    {
+        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+        if (static_cast<int>(m_pageDisplayData.size()) < clamped)
+        {
+            m_pageDisplayData.resize(static_cast<size_t>(clamped));
+        }
+    }
+
+    m_pageCountFinal.store(true);
+    m_pageCountEstimated.store(false);
+    if (m_pageCountCounted.load())
+    {
+        m_metadataDirty.store(true);
+    }
+}
+
+bool MuPdfDocument::reopenWithCSS(const std::string& css)
+{
+    if (m_filePath.empty())
+    {
+        std::cerr << "Cannot reopen document: no file path stored" << std::endl;
+        return false;
+    }
+
+    std::cout << "Reopening document with new CSS: " << css << std::endl;
 
     // Store the file path before any operations
     std::string savedPath = m_filePath;
 
-    // Stop any background operations before we touch shared state
+    // Stop any background operations before we touch shared state. Aborted
+    // renders may still be rasterizing outside m_renderMutex; let them finish
+    // so nothing laid out with the old style lands in the cache.
     cancelPrerendering();
     stopPageCountThread();
+    m_renderPool.wait(isRasterJob);
 
     std::unique_lock<std::mutex> renderLock(m_renderMutex);
-    std::unique_lock<std::mutex> prerenderLock(m_prerenderMutex);
 
-    {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        m_cache.clear();
-        m_argbCache.clear();
-    }
+    m_pageCache.clear();
 
-    // Close existing documents but keep contexts alive to avoid TG5040 crash
+    // Close the document but keep the context alive to avoid TG5040 crash
     m_doc.reset();
-    m_prerenderDoc.reset();
 
     // Update CSS on existing contexts
     m_userCSS = css;
@@ -437,27 +818,363 @@ bool MuPdfDocument::reopenWithCSS(const std::string& css)
         }
     }
 
-    if (m_prerenderCtx)
+    // Reopen documents using existing contexts (reuseContexts=true)
+    bool result = open(savedPath, true);
+
+    if (!result)
+    {
+        std::cerr << "Failed to reopen document with new CSS" << std::endl;
+    }
+
+    return result;
+}
+
+bool MuPdfDocument::beginRelayout(const std::string& css, int currentPage, int scale)
+{
+    if (!m_isReflowableDocument || m_filePath.empty() || !m_ctx || !m_doc)
+    {
+        return false;
+    }
+
+    // A bookmark names a position in the text rather than a page number, so
+    // it still points at the same paragraph after the page breaks move
+    fz_bookmark mark = 0;
+    bool marked = false;
+    {
+        std::lock_guard<std::mutex> renderLock(m_renderMutex);
+        fz_context* ctx = m_ctx.get();
+        fz_var(mark);
+        fz_var(marked);
+        fz_try(ctx)
+        {
+            fz_location location = fz_location_from_page_number(ctx, m_doc.get(), std::max(currentPage, 0));
+            mark = fz_make_bookmark(ctx, m_doc.get(), location);
+            marked = true;
+        }
+        fz_catch(ctx)
+        {
+            std::cerr << "MuPdfDocument: Failed to bookmark page " << currentPage << ": " << fz_caught_message(ctx)
+                      << std::endl;
+        }
+    }
+    if (!marked)
+    {
+        return false;
+    }
+
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> relayoutLock(m_relayoutMutex);
+        generation = m_relayout.generation + 1;
+        discardRelayoutDocument(m_relayout);
+        m_relayout = RelayoutState();
+        m_relayout.generation = generation;
+        m_relayout.pending = true;
+        m_relayout.css = css;
+        m_relayout.fromPage = currentPage;
+        m_relayout.scale = scale;
+    }
+
+    RenderWorkerPool::JobKey key;
+    key.kind = JOB_RELAYOUT;
+    key.page = static_cast<int>(generation & 0x7fffffff);
+    const std::string path = m_filePath;
+    const std::string identity = m_documentIdentity;
+    const unsigned char clearValue = pageClearValue();
+    if (!m_renderPool.submit(RenderWorkerPool::Priority::Visible, key,
+                             [this, path, identity, css, mark, scale, clearValue, generation]()
+                             { relayoutJob(path, identity, css, mark, scale, clearValue, generation); }))
+    {
+        std::lock_guard<std::mutex> relayoutLock(m_relayoutMutex);
+        if (m_relayout.generation == generation)
+        {
+            m_relayout.pending = false;
+        }
+        return false;
+    }
+
+    std::cout << "MuPdfDocument: Relayout started in the background from page " << currentPage << std::endl;
+    return true;
+}
+
+void MuPdfDocument::relayoutJob(const std::string& path, const std::string& identity, const std::string& css,
+                                fz_bookmark mark, int scale, unsigned char clearValue, uint64_t generation)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::string accelerator = documentAcceleratorPath(identity, css).string();
+
+    int pageNumber = -1;
+    fz_rect bounds = fz_empty_rect;
+    std::vector<uint32_t> buffer;
+    int width = 0;
+    int height = 0;
+
+    // A private context: the user CSS belongs to the context, and the old
+    // layout keeps rendering on m_ctx until finishRelayout() swaps
+    fz_context* ctx = MuPdfContextPool::shared().acquire();
+    fz_document* doc = nullptr;
+    if (ctx)
     {
-        fz_try(m_prerenderCtx.get())
+        fz_page* page = nullptr;
+        fz_device* dev = nullptr;
+        fz_pixmap* pix = nullptr;
+        fz_var(doc);
+        fz_var(page);
+        fz_var(dev);
+        fz_var(pix);
+        fz_var(pageNumber);
+        fz_var(bounds);
+        fz_var(width);
+        fz_var(height);
+
+        // Fonts must resolve as they do on m_ctx, or the pages break differently
+        if (m_fontLoaderInstaller)
+        {
+            m_fontLoaderInstaller(ctx);
+        }
+
+        fz_try(ctx)
+        {
+            fz_set_user_css(ctx, css.c_str());
+            doc = openDocumentAccelerated(ctx, path, accelerator);
+            fz_location location = fz_lookup_bookmark(ctx, doc, mark);
+            pageNumber = fz_page_number_from_location(ctx, doc, location);
+            if (pageNumber < 0)
+            {
+                fz_throw(ctx, FZ_ERROR_GENERIC, "Bookmark not found in the new layout");
+            }
+
+            page = fz_load_page(ctx, doc, pageNumber);
+            bounds = fz_bound_page(ctx, page);
+
+            // Tiled scales are drawn tile by tile; only the mapping is needed then
+            if (!shouldUseTiledRendering(scale))
+            {
+                PageScaleInfo info{};
+                info.bounds = bounds;
+                computeScaleGeometry(info, scale);
+                width = info.width;
+                height = info.height;
+                fz_irect bbox = info.bbox;
+                bbox.x1 = bbox.x0 + width;
+                bbox.y1 = bbox.y0 + height;
+
+                buffer.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+                pix = newArgbTargetPixmap(ctx, bbox, buffer.data(), width);
+                fz_clear_pixmap_with_value(ctx, pix, clearValue);
+                dev = fz_new_draw_device(ctx, fz_identity, pix);
+                fz_run_page(ctx, page, dev, info.transform, nullptr);
+                fz_close_device(ctx, dev);
+                finishArgbTargetPixmap(ctx, pix, buffer.data(), width);
+            }
+        }
+        fz_always(ctx)
         {
-            fz_set_user_css(m_prerenderCtx.get(), css.c_str());
+            fz_drop_device(ctx, dev);
+            fz_drop_pixmap(ctx, pix);
+            fz_drop_page(ctx, page);
         }
-        fz_catch(m_prerenderCtx.get())
+        fz_catch(ctx)
         {
-            std::cerr << "Failed to update CSS on prerender context: " << fz_caught_message(m_prerenderCtx.get()) << std::endl;
+            std::cerr << "MuPdfDocument: Background relayout failed: " << fz_caught_message(ctx) << std::endl;
+            pageNumber = -1;
+            buffer.clear();
         }
+        // The document is only laid out up to the page here; the chapter
+        // count saves the accelerator once it has laid out every chapter
     }
 
-    // Reopen documents using existing contexts (reuseContexts=true)
-    bool result = open(savedPath, true);
+    std::lock_guard<std::mutex> relayoutLock(m_relayoutMutex);
+    if (m_relayout.generation != generation || !m_relayout.pending)
+    {
+        // Superseded by a newer style or the document was closed
+        RelayoutState unused;
+        unused.ctx = ctx;
+        unused.doc = doc;
+        discardRelayoutDocument(unused);
+        return;
+    }
 
-    if (!result)
+    if (doc)
     {
-        std::cerr << "Failed to reopen document with new CSS" << std::endl;
+        // The document becomes m_doc as it is, already laid out up to the page
+        m_relayout.ctx = ctx;
+        m_relayout.doc = doc;
+    }
+    else
+    {
+        MuPdfContextPool::shared().release(ctx);
+    }
+    m_relayout.ready = true;
+    m_relayout.page = pageNumber;
+    m_relayout.bounds = bounds;
+    if (!buffer.empty())
+    {
+        m_relayout.pixels = PixelBufferPool::shared().adopt(std::move(buffer));
+        m_relayout.width = width;
+        m_relayout.height = height;
     }
 
-    return result;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "MuPdfDocument: Relayout mapped page " << m_relayout.fromPage << " to " << pageNumber << " ("
+              << elapsed.count() << " ms)" << std::endl;
+}
+
+bool MuPdfDocument::finishRelayout(int currentPage, int& mappedPage)
+{
+    RelayoutState done;
+    {
+        std::lock_guard<std::mutex> relayoutLock(m_relayoutMutex);
+        if (!m_relayout.pending || !m_relayout.ready)
+        {
+            return false;
+        }
+        done = m_relayout;
+        m_relayout.pending = false;
+        m_relayout.ready = false;
+        m_relayout.pixels.reset();
+        m_relayout.ctx = nullptr;
+        m_relayout.doc = nullptr;
+    }
+
+    if (done.doc)
+    {
+        mappedPage = adoptRelayoutDocument(done, currentPage);
+    }
+    else if (reopenWithCSS(done.css))
+    {
+        // Without a mapping keep the page number, as a plain reopen would
+        mappedPage = currentPage;
+    }
+    else
+    {
+        // The worker could not open the book either; reopening says why
+        mappedPage = -1;
+        return true;
+    }
+    ensurePageCountAtLeast(mappedPage + 1);
+
+    if (done.page >= 0)
+    {
+        {
+            std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+            recordPageBoundsLocked(done.page, done.bounds);
+        }
+        if (done.pixels)
+        {
+            m_pageCache.putArgb(PageCache::Key(done.page, done.scale), done.pixels, done.width, done.height);
+        }
+    }
+    return true;
+}
+
+int MuPdfDocument::adoptRelayoutDocument(RelayoutState& done, int currentPage)
+{
+    // Work for the old layout is worthless now. Aborted renders stop at their
+    // next cookie check and the count at the next chapter, so the waits are
+    // short; nothing is parsed or laid out here.
+    cancelPrerendering();
+    stopPageCountThread();
+    m_renderPool.wait(isRasterJob);
+    saveMetadata();
+
+    int mappedPage = done.page >= 0 ? done.page : currentPage;
+    {
+        std::lock_guard<std::mutex> renderLock(m_renderMutex);
+        const int textAa = fz_text_aa_level(m_ctx.get());
+        const int graphicsAa = fz_graphics_aa_level(m_ctx.get());
+
+        // The reader may have turned pages while the worker ran; map the page
+        // on screen now rather than the one the relayout started from
+        fz_bookmark mark = 0;
+        bool marked = false;
+        if (currentPage != done.fromPage || done.page < 0)
+        {
+            fz_context* ctx = m_ctx.get();
+            fz_var(mark);
+            fz_var(marked);
+            fz_try(ctx)
+            {
+                fz_location location = fz_location_from_page_number(ctx, m_doc.get(), std::max(currentPage, 0));
+                mark = fz_make_bookmark(ctx, m_doc.get(), location);
+                marked = true;
+            }
+            fz_catch(ctx)
+            {
+                std::cerr << "MuPdfDocument: Failed to bookmark page " << currentPage << ": "
+                          << fz_caught_message(ctx) << std::endl;
+            }
+        }
+
+        // As in releaseMuPdfResources(): clones and display lists first, then
+        // the old document and its context
+        m_rasterContexts.clear();
+        m_rasterContextsBase = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_workerRasterMutex);
+            m_idleRasterContexts.clear();
+            m_workerRasterBase = nullptr;
+        }
+        resetDisplayCache();
+        m_doc.reset();
+        m_ctx.reset(done.ctx);
+        m_doc = std::unique_ptr<fz_document, DocumentDeleter>(done.doc, DocumentDeleter{done.ctx});
+        done.ctx = nullptr;
+        done.doc = nullptr;
+
+        fz_set_text_aa_level(m_ctx.get(), textAa);
+        fz_set_graphics_aa_level(m_ctx.get(), graphicsAa);
+        m_userCSS = done.css;
+        m_metadataCss = done.css;
+        m_acceleratorPath = documentAcceleratorPath(m_documentIdentity, m_metadataCss).string();
+
+        loadLayoutState();
+        resetDisplayCache();
+        m_pageCache.clear();
+
+        if (marked)
+        {
+            // Usually a few pages from the worker's mapping, which is already
+            // laid out, so little layout work happens here
+            fz_context* ctx = m_ctx.get();
+            fz_var(mappedPage);
+            fz_try(ctx)
+            {
+                fz_location location = fz_lookup_bookmark(ctx, m_doc.get(), mark);
+                const int page = fz_page_number_from_location(ctx, m_doc.get(), location);
+                if (page >= 0)
+                {
+                    mappedPage = page;
+                }
+            }
+            fz_catch(ctx)
+            {
+                std::cerr << "MuPdfDocument: Failed to map page " << currentPage << " to the new layout: "
+                          << fz_caught_message(ctx) << std::endl;
+            }
+        }
+    }
+
+    std::cout << "MuPdfDocument: Switched to the relaid-out document" << std::endl;
+    if (!m_pageCountFinal.load())
+    {
+        startAsyncPageCount();
+    }
+    return mappedPage;
+}
+
+void MuPdfDocument::discardRelayoutDocument(RelayoutState& state)
+{
+    if (state.doc)
+    {
+        fz_drop_document(state.ctx, state.doc);
+    }
+    if (state.ctx)
+    {
+        MuPdfContextPool::shared().release(state.ctx);
+    }
+    state.doc = nullptr;
+    state.ctx = nullptr;
 }
 
 std::vector<unsigned char> MuPdfDocument::renderPage(int pageNumber, int& width, int& height, int zoom)
@@ -482,18 +1199,14 @@ std::vector<unsigned char> MuPdfDocument::renderPage(int pageNumber, int& width,
         ensurePageCountAtLeast(pageNumber + 1);
     }
 
-    auto key = std::make_pair(pageNumber, zoom);
+    PageCache::Key key(pageNumber, zoom);
 
+    PageCache::Entry cached;
+    if (m_pageCache.find(key, cached, PageCache::Format::Rgb))
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        auto it = m_cache.find(key);
-        if (it != m_cache.end())
-        {
-            auto& [buffer, cachedWidth, cachedHeight] = it->second;
-            width = cachedWidth;
-            height = cachedHeight;
-            return buffer;
-        }
+        width = cached.width;
+        height = cached.height;
+        return *cached.rgb;
     }
 
     ArgbBufferPtr argbData = renderPageARGB(pageNumber, width, height, zoom);
@@ -501,40 +1214,25 @@ std::vector<unsigned char> MuPdfDocument::renderPage(int pageNumber, int& width,
 
     if (argbData)
     {
-        const auto& pixels = *argbData;
-        for (int i = 0; i < width * height; ++i)
-        {
-            uint32_t argb = pixels[static_cast<size_t>(i)];
-            rgbBuffer[static_cast<size_t>(i) * 3] = static_cast<unsigned char>((argb >> 16) & 0xFF);
-            rgbBuffer[static_cast<size_t>(i) * 3 + 1] = static_cast<unsigned char>((argb >> 8) & 0xFF);
-            rgbBuffer[static_cast<size_t>(i) * 3 + 2] = static_cast<unsigned char>(argb & 0xFF);
-        }
+        pixel_convert::argbToRgb(argbData->data(), rgbBuffer.data(),
+                                 static_cast<size_t>(width) * static_cast<size_t>(height));
     }
 
-    {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-
-        if (zoom > 200 && m_cache.size() > 10)
-        {
-            auto it = m_cache.begin();
-            std::advance(it, static_cast<long>(m_cache.size() - 5));
-            m_cache.erase(m_cache.begin(), it);
-        }
-        else if (m_cache.size() > 20)
-        {
-            auto it = m_cache.begin();
-            std::advance(it, static_cast<long>(m_cache.size() - 15));
-            m_cache.erase(m_cache.begin(), it);
-        }
-
-        m_cache[key] = std::make_tuple(rgbBuffer, width, height);
-    }
+    m_pageCache.putRgb(key, std::make_shared<std::vector<unsigned char>>(rgbBuffer), width, height);
 
     return rgbBuffer;
 }
 
 MuPdfDocument::ArgbBufferPtr MuPdfDocument::renderPageARGB(int pageNumber, int& width, int& height, int zoom)
 {
+    return renderPageARGBImpl(pageNumber, width, height, zoom, m_draftRendering.load());
+}
+
+MuPdfDocument::ArgbBufferPtr MuPdfDocument::renderPageARGBImpl(int pageNumber, int& width, int& height, int zoom,
+                                                               bool draft)
+{
+    ForegroundRenderScope foreground(m_foregroundRenders);
+    m_focusPage.store(pageNumber);
     std::lock_guard<std::mutex> renderLock(m_renderMutex);
 
     if (!m_ctx || !m_doc)
@@ -557,18 +1255,14 @@ MuPdfDocument::ArgbBufferPtr MuPdfDocument::renderPageARGB(int pageNumber, int&
         ensurePageCountAtLeast(pageNumber + 1);
     }
 
-    auto key = std::make_pair(pageNumber, zoom);
+    PageCache::Key key(pageNumber, zoom);
 
+    PageCache::Entry cached;
+    if (m_pageCache.find(key, cached, PageCache::Format::Argb))
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        auto it = m_argbCache.find(key);
-        if (it != m_argbCache.end())
-        {
-            auto& [buffer, cachedWidth, cachedHeight] = it->second;
-            width = cachedWidth;
-            height = cachedHeight;
-            return buffer;
-        }
+        width = cached.width;
+        height = cached.height;
+        return cached.argb;
     }
 
     fz_context* ctx = m_ctx.get();
@@ -597,177 +1291,193 @@ MuPdfDocument::ArgbBufferPtr MuPdfDocument::renderPageARGB(int pageNumber, int&
         throw std::runtime_error("Display list missing for page " + std::to_string(pageNumber));
     }
 
-    fz_pixmap* pix = nullptr;
-    fz_device* dev = nullptr;
-    fz_var(pix);
-    fz_var(dev);
-    std::vector<uint32_t> argbBuffer;
-
-    fz_try(ctx)
+    PixelBufferPool::BufferPtr argbBuffer;
     {
-        pix = fz_new_pixmap_with_bbox(ctx, fz_device_rgb(ctx), scaleInfo.bbox, nullptr, 1);
-        if (!pix)
-        {
-            fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to allocate pixmap for page %d", pageNumber);
-        }
+        ScopedDraftAntialias antialias(ctx, draft);
+        argbBuffer = rasterizeDisplayListARGB(ctx, scaleInfo.displayList, scaleInfo.transform, scaleInfo.bbox, pageNumber);
+    }
+    width = scaleInfo.width;
+    height = scaleInfo.height;
 
-        // PDF content expects a white canvas; other formats can inherit themed backgrounds
-        unsigned char clearValue = 255;
-        if (!m_isPdfDocument)
-        {
-            clearValue = static_cast<unsigned char>((m_bgR + m_bgG + m_bgB) / 3);
-        }
-        fz_clear_pixmap_with_value(ctx, pix, clearValue);
+    ArgbBufferPtr bufferPtr = std::move(argbBuffer);
+    // Drafts are shown once and then replaced, so they never reach the caches
+    if (!draft)
+    {
+        m_pageCache.putArgb(key, bufferPtr, width, height);
+        queueDiskCacheWrite(pageNumber, zoom, bufferPtr, width, height);
+    }
 
-        dev = fz_new_draw_device(ctx, fz_identity, pix);
-        if (!dev)
-        {
-            fz_drop_pixmap(ctx, pix);
-            pix = nullptr;
-            fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to create draw device for page %d", pageNumber);
-        }
+    return bufferPtr;
+}
 
-        // Clip rectangle must be in device space, otherwise high zoom levels clip content.
-        fz_rect clipRect = scaleInfo.bounds;
-        clipRect = fz_transform_rect(clipRect, scaleInfo.transform);
-        fz_run_display_list(ctx, scaleInfo.displayList, dev, scaleInfo.transform, clipRect, nullptr);
-        fz_close_device(ctx, dev);
-        fz_drop_device(ctx, dev);
-        dev = nullptr;
+bool MuPdfDocument::renderPageARGBInto(int pageNumber, int zoom, int& width, int& height, const PixelTarget& acquire)
+{
+    ForegroundRenderScope foreground(m_foregroundRenders);
+    m_focusPage.store(pageNumber);
+    std::lock_guard<std::mutex> renderLock(m_renderMutex);
 
-        width = scaleInfo.width;
-        height = scaleInfo.height;
+    if (!m_ctx || !m_doc)
+    {
+        throw std::runtime_error("Document not open");
+    }
 
-        argbBuffer.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
-        const unsigned char* samples = fz_pixmap_samples(ctx, pix);
-        int stride = fz_pixmap_stride(ctx, pix);
+    int currentPageCount = m_pageCount.load();
+    if (pageNumber < 0)
+    {
+        throw std::runtime_error("Invalid page number: " + std::to_string(pageNumber));
+    }
 
-        if (!samples || stride <= 0 || stride < width * 4)
+    if (pageNumber >= currentPageCount)
+    {
+        if (m_pageCountFinal.load())
         {
-            if (pix)
-            {
-                fz_drop_pixmap(ctx, pix);
-                pix = nullptr;
-            }
-            fz_throw(ctx, FZ_ERROR_GENERIC, "Invalid pixmap data for page %d (samples=%p, stride=%d, width=%d)",
-                     pageNumber, static_cast<const void*>(samples), stride, width);
+            throw std::runtime_error("Invalid page number: " + std::to_string(pageNumber));
         }
+        ensurePageCountAtLeast(pageNumber + 1);
+    }
 
-        for (int y = 0; y < height; ++y)
+    try
+    {
+        ensureDisplayList(pageNumber);
+    }
+    catch (const std::exception& e)
+    {
+        if (!m_pageCountFinal.load())
         {
-            const unsigned char* srcRow = samples + static_cast<size_t>(y) * stride;
-            for (int x = 0; x < width; ++x)
-            {
-                const unsigned char* srcPixel = srcRow + static_cast<size_t>(x) * 4;
-                uint32_t r = static_cast<uint32_t>(srcPixel[0]);
-                uint32_t g = static_cast<uint32_t>(srcPixel[1]);
-                uint32_t b = static_cast<uint32_t>(srcPixel[2]);
-                uint32_t a = static_cast<uint32_t>(srcPixel[3]);
-                argbBuffer[static_cast<size_t>(y) * width + x] = (a << 24) | (r << 16) | (g << 8) | b;
-            }
+            finalizePageCount(std::max(pageNumber, 1));
         }
-        fz_drop_pixmap(ctx, pix);
-        pix = nullptr;
+        throw;
     }
-    fz_catch(ctx)
-    {
-        if (dev)
-            fz_drop_device(ctx, dev);
-        if (pix)
-            fz_drop_pixmap(ctx, pix);
 
-        const char* muErr = fz_caught_message(ctx);
-        std::string message = "Error rendering page " + std::to_string(pageNumber);
-        if (muErr && strlen(muErr) > 0)
-        {
-            message += ": ";
-            message += muErr;
-        }
-        std::cerr << "MuPdfDocument: " << message << std::endl;
-        throw std::runtime_error(message);
-    }
+    PageScaleInfo scaleInfo = computePageScaleInfoLocked(pageNumber, zoom);
 
-    ArgbBufferPtr bufferPtr = std::make_shared<std::vector<uint32_t>>(std::move(argbBuffer));
+    if (!scaleInfo.displayList)
+    {
+        throw std::runtime_error("Display list missing for page " + std::to_string(pageNumber));
+    }
 
+    int pitch = 0;
+    uint32_t* dest = acquire(scaleInfo.width, scaleInfo.height, pitch);
+    if (!dest)
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-#ifdef TRIMUI_PLATFORM
-        if (m_argbCache.size() >= 2)
-        {
-#else
-        if (m_argbCache.size() >= 5)
-        {
-#endif
-            m_argbCache.erase(m_argbCache.begin());
-        }
+        return false;
+    }
+    if (pitch < scaleInfo.width * static_cast<int>(sizeof(uint32_t)) || pitch % sizeof(uint32_t) != 0)
+    {
+        throw std::runtime_error("Unusable pitch " + std::to_string(pitch) + " for page " + std::to_string(pageNumber));
+    }
 
-        m_argbCache[key] = std::make_tuple(bufferPtr, width, height);
+    const bool draft = m_draftRendering.load();
+    {
+        ScopedDraftAntialias antialias(m_ctx.get(), draft);
+        rasterizeDisplayListInto(m_ctx.get(), scaleInfo.displayList, scaleInfo.transform, scaleInfo.bbox, pageNumber,
+                                 dest, pitch / static_cast<int>(sizeof(uint32_t)));
     }
+    width = scaleInfo.width;
+    height = scaleInfo.height;
 
-    return bufferPtr;
+    // The disk cache is the one consumer that needs a copy of the pixels
+    if (!draft && m_diskCache && !m_documentIdentity.empty())
+    {
+        auto copy = PixelBufferPool::shared().acquire(static_cast<size_t>(width) * static_cast<size_t>(height));
+        pixel_convert::copyRows32(reinterpret_cast<const uint8_t*>(dest), pitch, copy->data(), width, height);
+        queueDiskCacheWrite(pageNumber, zoom, copy, width, height);
+    }
+    return true;
 }
 
 bool MuPdfDocument::tryGetCachedPageARGB(int pageNumber, int scale, ArgbBufferPtr& buffer, int& width, int& height)
 {
-    auto key = std::make_pair(pageNumber, scale);
+    PageCache::Key key(pageNumber, scale);
 
-    std::vector<unsigned char> rgbCopy;
+    PageCache::Entry cached;
+    if (!m_pageCache.find(key, cached))
+    {
+        return false;
+    }
 
+    width = cached.width;
+    height = cached.height;
+    if (cached.argb)
     {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-        auto argbIt = m_argbCache.find(key);
-        if (argbIt != m_argbCache.end())
-        {
-            auto& [cachedBuffer, cachedWidth, cachedHeight] = argbIt->second;
-            buffer = cachedBuffer;
-            width = cachedWidth;
-            height = cachedHeight;
-            return static_cast<bool>(buffer);
-        }
+        buffer = cached.argb;
+        noteCachedRenderShown(key);
+        return true;
+    }
 
-        auto rgbIt = m_cache.find(key);
-        if (rgbIt != m_cache.end())
-        {
-            rgbCopy = std::get<0>(rgbIt->second);
-            width = std::get<1>(rgbIt->second);
-            height = std::get<2>(rgbIt->second);
-        }
-        else
-        {
-            return false;
-        }
+    if (!cached.rgb || cached.rgb->empty() || width <= 0 || height <= 0)
+    {
+        return false;
     }
 
-    if (rgbCopy.empty() || width <= 0 || height <= 0)
+    auto converted = PixelBufferPool::shared().acquire(static_cast<size_t>(width) * static_cast<size_t>(height));
+    pixel_convert::rgbToArgb(cached.rgb->data(), converted->data(), converted->size());
+
+    m_pageCache.putArgb(key, converted, width, height);
+
+    buffer = std::move(converted);
+    return static_cast<bool>(buffer);
+}
+
+void MuPdfDocument::setDiskPageCache(std::shared_ptr<DiskPageCache> cache)
+{
+    m_diskCache = std::move(cache);
+}
+
+bool MuPdfDocument::tryLoadPageFromDiskCache(int pageNumber, int scale, ArgbBufferPtr& buffer, int& width, int& height)
+{
+    DiskPageCache::Key diskKey;
+    if (!diskCacheKey(pageNumber, scale, diskKey))
     {
         return false;
     }
 
-    auto converted = std::make_shared<std::vector<uint32_t>>(static_cast<size_t>(width) * static_cast<size_t>(height));
-    const unsigned char* src = rgbCopy.data();
-    for (size_t i = 0; i < converted->size(); ++i)
+    // The size is only known once the file is read; the vector joins the pool when released
+    auto pixels = PixelBufferPool::shared().adopt(PixelBufferPool::Buffer());
+    int loadedWidth = 0;
+    int loadedHeight = 0;
+    if (!m_diskCache->load(diskKey, *pixels, loadedWidth, loadedHeight))
     {
-        (*converted)[i] = (0xFFu << 24) | (static_cast<uint32_t>(src[i * 3]) << 16) |
-                          (static_cast<uint32_t>(src[i * 3 + 1]) << 8) | static_cast<uint32_t>(src[i * 3 + 2]);
+        return false;
     }
 
+    m_pageCache.putArgb(PageCache::Key(pageNumber, scale), pixels, loadedWidth, loadedHeight);
     {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-#ifdef TRIMUI_PLATFORM
-        if (m_argbCache.size() >= 2)
-        {
-#else
-        if (m_argbCache.size() >= 5)
-        {
-#endif
-            m_argbCache.erase(m_argbCache.begin());
-        }
+        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+        m_dimensionCache[std::make_pair(pageNumber, scale)] = {loadedWidth, loadedHeight};
+    }
+
+    buffer = std::move(pixels);
+    width = loadedWidth;
+    height = loadedHeight;
+    return true;
+}
 
-        m_argbCache[key] = std::make_tuple(converted, width, height);
+bool MuPdfDocument::diskCacheKey(int pageNumber, int scale, DiskPageCache::Key& key) const
+{
+    if (!m_diskCache || m_documentIdentity.empty() || shouldUseTiledRendering(scale))
+    {
+        return false;
     }
 
-    buffer = std::move(converted);
-    return static_cast<bool>(buffer);
+    // Everything besides the page and scale that changes the rendered pixels:
+    // layout and theme CSS, the canvas colour and the downsampling limit
+    key.document = m_documentIdentity;
+    key.variant = m_userCSS + "|" + std::to_string(pageClearValue()) + "|" + std::to_string(m_maxWidth) + "x" +
+                  std::to_string(m_maxHeight);
+    key.page = pageNumber;
+    key.scale = scale;
+    return true;
+}
+
+void MuPdfDocument::queueDiskCacheWrite(int pageNumber, int scale, const ArgbBufferPtr& buffer, int width, int height)
+{
+    DiskPageCache::Key diskKey;
+    if (!buffer || !diskCacheKey(pageNumber, scale, diskKey) || m_diskCache->contains(diskKey))
+    {
+        return;
+    }
+    m_diskCache->storeAsync(diskKey, buffer, width, height);
 }
 
 void MuPdfDocument::requestPageRenderAsync(int page, int scale)
@@ -782,57 +1492,320 @@ void MuPdfDocument::requestPageRenderAsync(int page, int scale)
         return;
     }
 
-    auto key = std::make_pair(page, scale);
+    // High zoom levels are drawn from tiles; a whole-page raster would be wasted.
+    if (shouldUseTiledRendering(scale))
+    {
+        return;
+    }
+
+    if (m_pageCache.containsArgb(PageCache::Key(page, scale)))
+    {
+        return;
+    }
+
+    // Drop older requests for the same page so we only render the newest scale.
+    m_renderPool.cancel([page, scale](const RenderWorkerPool::JobKey& pending)
+                        { return isJobKind(pending, JOB_PAGE_RENDER) && pending.page == page && pending.scale != scale; });
+
+    RenderWorkerPool::JobKey key;
+    key.kind = JOB_PAGE_RENDER;
+    key.page = page;
+    key.scale = scale;
+    const uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
+    m_renderPool.submit(RenderWorkerPool::Priority::Visible, key, [this, page, scale, generation]()
+                        { renderPageAsyncJob(page, scale, generation); });
+}
+
+void MuPdfDocument::requestPagePreviewAsync(int page, int scale)
+{
+    if (m_asyncShutdown.load() || m_pageCache.containsArgb(PageCache::Key(page, scale)))
+    {
+        return;
+    }
+
+    // Queued at the same priority as the full render but ahead of it. The
+    // page is interpreted once, into the display list both passes draw from,
+    // so the first pass mostly adds a small raster.
+    RenderWorkerPool::JobKey key;
+    key.kind = JOB_PAGE_PREVIEW;
+    key.page = page;
+    key.scale = scale;
+    const uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
+    m_renderPool.submit(RenderWorkerPool::Priority::Visible, key, [this, page, scale, generation]()
+                        { prerenderPageInternal(page, scale, generation, false); });
+}
+
+void MuPdfDocument::setTiledRenderingEnabled(bool enabled)
+{
+    if (m_tiledRenderingEnabled.exchange(enabled) == enabled)
+    {
+        return;
+    }
+
+    // Page dimensions at high zoom depend on the mode, so drop anything sized for the old one
+    m_pageCache.clear();
+    std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+    m_dimensionCache.clear();
+}
+
+bool MuPdfDocument::shouldUseTiledRendering(int scale) const
+{
+    return m_tiledRenderingEnabled.load() && scale >= TILED_RENDER_MIN_SCALE;
+}
+
+bool MuPdfDocument::tryGetCachedTileARGB(int pageNumber, int scale, int tileX, int tileY, ArgbBufferPtr& buffer,
+                                         int& width, int& height)
+{
+    PageCache::Key key(pageNumber, scale, tileX, tileY);
+    PageCache::Entry cached;
+    if (!m_pageCache.find(key, cached, PageCache::Format::Argb))
+    {
+        return false;
+    }
+
+    buffer = cached.argb;
+    width = cached.width;
+    height = cached.height;
+    noteCachedRenderShown(key);
+    return true;
+}
+
+MuPdfDocument::ArgbBufferPtr MuPdfDocument::renderTileARGB(int pageNumber, int zoom, int tileX, int tileY,
+                                                           int& width, int& height)
+{
+    return renderTileARGB(pageNumber, zoom, tileX, tileY, width, height, nullptr);
+}
+
+MuPdfDocument::ArgbBufferPtr MuPdfDocument::renderTileARGB(int pageNumber, int zoom, int tileX, int tileY,
+                                                           int& width, int& height, fz_cookie* cookie)
+{
+    PageCache::Key key(pageNumber, zoom, tileX, tileY);
+    fz_context* rasterCtx = nullptr;
+    fz_display_list* list = nullptr;
+    fz_matrix transform{};
+    fz_irect tileBox{};
 
+    // Only the display list lookup needs the document; the tile is drawn on
+    // a context of its own, so the page on screen and the other tiles keep
+    // rendering meanwhile
     {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        if (m_argbCache.find(key) != m_argbCache.end())
+        std::lock_guard<std::mutex> renderLock(m_renderMutex);
+
+        if (!m_ctx || !m_doc)
         {
-            return;
+            throw std::runtime_error("Document not open");
+        }
+
+        if (pageNumber < 0 || pageNumber >= m_pageCount.load() || tileX < 0 || tileY < 0)
+        {
+            throw std::runtime_error("Invalid tile " + std::to_string(tileX) + "," + std::to_string(tileY) +
+                                     " on page " + std::to_string(pageNumber));
+        }
+
+        PageCache::Entry cached;
+        if (m_pageCache.find(key, cached, PageCache::Format::Argb))
+        {
+            width = cached.width;
+            height = cached.height;
+            return cached.argb;
+        }
+
+        ensureDisplayList(pageNumber, cookie);
+        PageScaleInfo scaleInfo = computePageScaleInfoLocked(pageNumber, zoom);
+        if (!scaleInfo.displayList)
+        {
+            throw std::runtime_error("Display list missing for page " + std::to_string(pageNumber));
+        }
+
+        tileBox.x0 = scaleInfo.bbox.x0 + tileX * TILE_SIZE;
+        tileBox.y0 = scaleInfo.bbox.y0 + tileY * TILE_SIZE;
+        tileBox.x1 = std::min(tileBox.x0 + TILE_SIZE, scaleInfo.bbox.x1);
+        tileBox.y1 = std::min(tileBox.y0 + TILE_SIZE, scaleInfo.bbox.y1);
+        if (tileBox.x0 >= tileBox.x1 || tileBox.y0 >= tileBox.y1)
+        {
+            throw std::runtime_error("Tile " + std::to_string(tileX) + "," + std::to_string(tileY) +
+                                     " is outside page " + std::to_string(pageNumber));
+        }
+
+        rasterCtx = acquireWorkerRasterContextLocked();
+        if (!rasterCtx)
+        {
+            throw std::runtime_error("No context to render page " + std::to_string(pageNumber));
         }
+        transform = scaleInfo.transform;
+        // Keep the list alive even if the display cache is reset meanwhile
+        list = fz_keep_display_list(m_ctx.get(), scaleInfo.displayList);
     }
 
-    std::unique_lock<std::mutex> lock(m_asyncRenderMutex);
-    if (m_asyncShutdown)
+    ArgbBufferPtr bufferPtr;
+    try
+    {
+        // Tiles are never banded: they already render in parallel with each other
+        bufferPtr = rasterizeDisplayListARGB(rasterCtx, list, transform, tileBox, pageNumber, cookie, false);
+    }
+    catch (...)
+    {
+        fz_drop_display_list(rasterCtx, list);
+        releaseWorkerRasterContext(rasterCtx);
+        throw;
+    }
+    fz_drop_display_list(rasterCtx, list);
+    releaseWorkerRasterContext(rasterCtx);
+
+    // Tiles stay in memory only: the disk cache is keyed by whole pages
+    width = tileBox.x1 - tileBox.x0;
+    height = tileBox.y1 - tileBox.y0;
+    m_pageCache.putArgb(key, bufferPtr, width, height);
+
+    return bufferPtr;
+}
+
+void MuPdfDocument::requestTileRenderAsync(int page, int scale, int tileX, int tileY)
+{
+    if (!m_ctx || !m_doc || m_asyncShutdown)
     {
         return;
     }
 
-    // Drop older requests for the same page so we only render the newest scale.
-    if (!m_asyncRenderQueue.empty())
+    if (m_pageCache.containsArgb(PageCache::Key(page, scale, tileX, tileY)))
     {
-        m_asyncRenderQueue.erase(std::remove_if(m_asyncRenderQueue.begin(), m_asyncRenderQueue.end(),
-                                                [page](const std::pair<int, int>& pending)
-                                                {
-                                                    return pending.first == page;
-                                                }),
-                                 m_asyncRenderQueue.end());
+        return;
     }
 
-    if (isRenderableQueued(key))
+    // Tiles for another page or zoom level are no longer worth rendering
+    m_renderPool.cancel([page, scale](const RenderWorkerPool::JobKey& pending)
+                        { return isJobKind(pending, JOB_TILE_RENDER) && (pending.page != page || pending.scale != scale); });
+
+    RenderWorkerPool::JobKey key;
+    key.kind = JOB_TILE_RENDER;
+    key.page = page;
+    key.scale = scale;
+    key.tileX = tileX;
+    key.tileY = tileY;
+    const uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
+    m_renderPool.submit(RenderWorkerPool::Priority::PreviewUpgrade, key, [this, page, scale, tileX, tileY, generation]()
+                        {
+        if (m_asyncShutdown || isPrerenderRequestStale(generation) ||
+            m_pageCache.containsArgb(PageCache::Key(page, scale, tileX, tileY)))
+        {
+            return;
+        }
+        // Tiles reuse the page's display list and rasterize on a worker context
+        ScopedRenderCookie cookie(*this, generation);
+        try
+        {
+            int tileW = 0;
+            int tileH = 0;
+            renderTileARGB(page, scale, tileX, tileY, tileW, tileH, cookie.get());
+        }
+        catch (const std::exception& e)
+        {
+            if (!cookie.aborted())
+            {
+                std::cerr << "MuPdfDocument: async tile render failed: " << e.what() << std::endl;
+            }
+        } });
+}
+
+void MuPdfDocument::requestSpeculativeRender(int page, int scale, int tileX, int tileY)
+{
+    if (!m_ctx || !m_doc || m_asyncShutdown)
     {
         return;
     }
 
-    m_asyncRenderQueue.push_back(key);
+    const bool tile = tileX >= 0 && tileY >= 0;
+    if (!tile && shouldUseTiledRendering(scale))
+    {
+        return;
+    }
 
-    if (!m_asyncWorkerRunning.load())
+    const PageCache::Key cacheKey(page, scale, tileX, tileY);
+    if (m_pageCache.containsArgb(cacheKey))
     {
-        m_asyncWorkerRunning = true;
-        if (!m_asyncRenderThread.joinable())
+        return;
+    }
+
+    // Only the newest prediction is worth finishing
+    m_renderPool.cancel([page, scale](const RenderWorkerPool::JobKey& pending)
+                        { return isJobKind(pending, JOB_SPECULATIVE) && (pending.page != page || pending.scale != scale); });
+
+    RenderWorkerPool::JobKey key;
+    key.kind = JOB_SPECULATIVE;
+    key.page = page;
+    key.scale = scale;
+    key.tileX = tileX;
+    key.tileY = tileY;
+    const uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
+    m_renderPool.submit(RenderWorkerPool::Priority::Neighbor, key, [this, page, scale, tileX, tileY, tile, cacheKey, generation]()
+                        {
+        if (m_asyncShutdown || isPrerenderRequestStale(generation) || m_pageCache.containsArgb(cacheKey))
         {
-            m_asyncRenderThread = std::thread(&MuPdfDocument::asyncRenderWorker, this);
+            return;
         }
-    }
 
-    lock.unlock();
-    m_asyncRenderCv.notify_one();
+        if (tile)
+        {
+            ScopedRenderCookie cookie(*this, generation);
+            try
+            {
+                int tileW = 0;
+                int tileH = 0;
+                renderTileARGB(page, scale, tileX, tileY, tileW, tileH, cookie.get());
+            }
+            catch (const std::exception& e)
+            {
+                if (!cookie.aborted())
+                {
+                    std::cerr << "MuPdfDocument: speculative tile render failed: " << e.what() << std::endl;
+                }
+            }
+        }
+        else
+        {
+            renderPageAsyncJob(page, scale, generation);
+        }
+
+        if (!m_pageCache.containsArgb(cacheKey))
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_speculativeMutex);
+        ++m_speculativeStats.rendered;
+        m_speculativeKeys.insert(cacheKey);
+        if (m_speculativeKeys.size() > MAX_TRACKED_SPECULATIVE)
+        {
+            m_speculativeKeys.erase(m_speculativeKeys.begin());
+        } });
+}
+
+MuPdfDocument::SpeculativeStats MuPdfDocument::getSpeculativeStats() const
+{
+    std::lock_guard<std::mutex> lock(m_speculativeMutex);
+    return m_speculativeStats;
+}
+
+void MuPdfDocument::noteCachedRenderShown(const PageCache::Key& key)
+{
+    std::lock_guard<std::mutex> lock(m_speculativeMutex);
+    if (m_speculativeKeys.erase(key) > 0)
+    {
+        ++m_speculativeStats.used;
+    }
 }
+
 int MuPdfDocument::getPageWidthNative(int pageNumber)
 {
     if (!m_ctx || !m_doc)
         return 0;
 
+    fz_rect known;
+    if (knownPageBounds(pageNumber, known))
+    {
+        return std::max(1, static_cast<int>(std::round(known.x1 - known.x0)));
+    }
+
     std::lock_guard<std::mutex> renderLock(m_renderMutex);
     try
     {
@@ -864,6 +1837,12 @@ int MuPdfDocument::getPageHeightNative(int pageNumber)
     if (!m_ctx || !m_doc)
         return 0;
 
+    fz_rect known;
+    if (knownPageBounds(pageNumber, known))
+    {
+        return std::max(1, static_cast<int>(std::round(known.y1 - known.y0)));
+    }
+
     std::lock_guard<std::mutex> renderLock(m_renderMutex);
     try
     {
@@ -906,6 +1885,18 @@ std::pair<int, int> MuPdfDocument::getPageDimensionsEffective(int pageNumber, in
     if (!m_ctx || !m_doc)
         return {0, 0};
 
+    // Sizes known from the metadata sidecar need no page load
+    fz_rect known;
+    if (knownPageBounds(pageNumber, known))
+    {
+        PageScaleInfo info{};
+        info.bounds = known;
+        computeScaleGeometry(info, zoom);
+        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+        m_dimensionCache[key] = {info.width, info.height};
+        return {info.width, info.height};
+    }
+
     std::lock_guard<std::mutex> renderLock(m_renderMutex);
 
     try
@@ -979,11 +1970,7 @@ void MuPdfDocument::setMaxRenderSize(int width, int height)
         return;
     }
 
-    {
-        std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-        m_cache.clear();
-        m_argbCache.clear();
-    }
+    m_pageCache.clear();
 
     {
         std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
@@ -995,28 +1982,36 @@ void MuPdfDocument::close()
 {
     cancelPrerendering();
     stopPageCountThread();
-    joinAsyncRenderThread();
+    drainRenderPool();
+    saveMetadata();
 
-    m_doc.reset();
-    m_ctx.reset();
-    m_prerenderDoc.reset();
-    m_prerenderCtx.reset();
+    {
+        std::lock_guard<std::mutex> relayoutLock(m_relayoutMutex);
+        const uint64_t generation = m_relayout.generation;
+        discardRelayoutDocument(m_relayout);
+        m_relayout = RelayoutState();
+        m_relayout.generation = generation;
+    }
 
+    releaseMuPdfResources();
+
+    m_pageCache.clear();
+    m_documentIdentity.clear();
     {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-        m_cache.clear();
-        m_argbCache.clear();
+        std::lock_guard<std::mutex> speculativeLock(m_speculativeMutex);
+        m_speculativeKeys.clear();
     }
 
     {
         std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
         m_dimensionCache.clear();
+        m_knownPageBounds.clear();
     }
 
     m_pageCount.store(0);
     m_pageCountFinal.store(false);
     m_pageCountEstimated.store(false);
-    m_pageCountThreadActive.store(false);
+    m_pageCountCounted.store(false);
     m_isPdfDocument = false;
     m_isReflowableDocument = false;
     resetDisplayCache();
@@ -1024,82 +2019,173 @@ void MuPdfDocument::close()
 
 void MuPdfDocument::clearCache()
 {
-    {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-        m_cache.clear();
-        m_argbCache.clear();
-    }
+    m_pageCache.clear();
     {
         std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
         m_dimensionCache.clear();
     }
 }
 
-void MuPdfDocument::cancelPrerendering()
+void MuPdfDocument::setPageCacheBudget(size_t bytes)
 {
-    m_prerenderGeneration.fetch_add(1, std::memory_order_relaxed);
-
-    if (m_prerenderThread.joinable())
-    {
-        m_prerenderActive = false;
-        m_prerenderThread.join();
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(m_asyncRenderMutex);
-        m_asyncRenderQueue.clear();
-    }
+    m_pageCache.setBudgetBytes(bytes);
+    PixelBufferPool::shared().setBudgetBytes(bytes / PixelBufferPool::CACHE_BUDGET_DIVISOR);
 }
 
-void MuPdfDocument::prerenderPage(int pageNumber, int scale)
+PageCache::Stats MuPdfDocument::getPageCacheStats() const
 {
-    uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
-    prerenderPageInternal(pageNumber, scale, generation);
+    return m_pageCache.getStats();
 }
 
-void MuPdfDocument::prerenderAdjacentPages(int currentPage, int scale)
+void MuPdfDocument::setDisplayListBudget(size_t bytes)
 {
-    uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
-    prerenderAdjacentPagesInternal(currentPage, scale, generation);
+    std::lock_guard<std::mutex> renderLock(m_renderMutex);
+    std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+    m_displayListBudget = bytes;
+    evictDisplayListsLocked(-1);
 }
 
-void MuPdfDocument::prerenderAdjacentPagesAsync(int currentPage, int scale)
+MuPdfDocument::DisplayListStats MuPdfDocument::getDisplayListStats() const
 {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastPrerenderTime).count();
-    if (elapsed < PRERENDER_COOLDOWN_MS)
+    std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+    DisplayListStats stats;
+    for (const auto& entry : m_pageDisplayData)
     {
-        return;
+        if (entry.displayList)
+        {
+            ++stats.entries;
+        }
     }
+    stats.bytes = m_displayListBytes;
+    stats.budgetBytes = m_displayListBudget;
+    stats.builds = m_displayListBuilds;
+    stats.evictions = m_displayListEvictions;
+    return stats;
+}
 
-    if (m_prerenderActive)
-    {
+void MuPdfDocument::shrinkStore(int percent)
+{
+    std::lock_guard<std::mutex> renderLock(m_renderMutex);
+    if (!m_ctx)
+    {
         return;
     }
+    fz_shrink_store(m_ctx.get(), static_cast<unsigned int>(std::max(0, std::min(percent, 100))));
+}
 
-    if (m_prerenderThread.joinable())
+void MuPdfDocument::dropPrerenderedPages()
+{
+    const int focus = m_focusPage.load();
+    const size_t dropped = m_pageCache.eraseIf([focus](const PageCache::Key& key)
+                                               { return key.page != focus; });
     {
-        m_prerenderActive = false;
-        m_prerenderThread.join();
+        std::lock_guard<std::mutex> lock(m_speculativeMutex);
+        m_speculativeKeys.clear();
+    }
+    // The dropped pages' buffers went back to the pool; let them go too
+    PixelBufferPool::shared().trim(0);
+    std::cout << "MuPdfDocument: Dropped " << dropped << " prerendered pages" << std::endl;
+}
+
+void MuPdfDocument::releaseDisplayLists()
+{
+    std::lock_guard<std::mutex> renderLock(m_renderMutex);
+    std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+    const size_t budget = m_displayListBudget;
+    m_displayListBudget = 0;
+    evictDisplayListsLocked(-1);
+    m_displayListBudget = budget;
+}
+
+void MuPdfDocument::cancelPrerendering()
+{
+    const uint64_t generation = m_prerenderGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+    abortStaleRenderCookies(generation);
+
+    // Running jobs stop at their next cookie check and discard the partial
+    // result; only queued work is dropped here, so this never blocks. The
+    // chapter count and a relayout do not depend on the page being viewed.
+    m_renderPool.cancel([](const RenderWorkerPool::JobKey& pending)
+                        { return !isJobKind(pending, JOB_PAGE_COUNT) && !isJobKind(pending, JOB_RELAYOUT); });
+}
+
+bool MuPdfDocument::isPrerenderingActive() const
+{
+    return m_renderPool.isPending([](const RenderWorkerPool::JobKey& pending)
+                                  { return isJobKind(pending, JOB_PRERENDER); });
+}
+
+void MuPdfDocument::setRenderWorkerCount(int count)
+{
+    m_renderPool.setWorkerCount(count);
+}
+
+int MuPdfDocument::getRenderWorkerCount() const
+{
+    return m_renderPool.getWorkerCount();
+}
+
+void MuPdfDocument::prerenderPage(int pageNumber, int scale)
+{
+    uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
+    prerenderPageInternal(pageNumber, scale, generation);
+}
+
+void MuPdfDocument::prerenderAdjacentPages(int currentPage, int scale)
+{
+    uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
+    prerenderAdjacentPagesInternal(currentPage, scale, generation);
+}
+
+void MuPdfDocument::prerenderAdjacentPagesAsync(int currentPage, int scale)
+{
+    // Same order as prerenderAdjacentPagesInternal: next, previous, then the one after next
+    prerenderPagesAsync(currentPage, {currentPage + 1, currentPage - 1, currentPage + 2}, scale);
+}
+
+bool MuPdfDocument::prerenderPagesAsync(int currentPage, const std::vector<int>& pages, int scale)
+{
+    m_focusPage.store(currentPage);
+
+    // Whole-page prerenders at tiled zoom levels would defeat the point of tiling
+    if (shouldUseTiledRendering(scale) || m_asyncShutdown)
+    {
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastPrerenderTime).count();
+    if (elapsed < PRERENDER_COOLDOWN_MS)
+    {
+        return false;
+    }
+
+    if (isPrerenderingActive())
+    {
+        return false;
     }
 
     m_lastPrerenderTime = now;
-    m_prerenderActive = true;
 
-    uint64_t generation = m_prerenderGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+    // Jobs are tied to the current generation; only cancelPrerendering() advances it
+    const uint64_t generation = m_prerenderGeneration.load(std::memory_order_relaxed);
 
-    m_prerenderThread = std::thread([this, currentPage, scale, generation]()
-                                    {
-        try
-        {
-            prerenderAdjacentPagesInternal(currentPage, scale, generation);
-        }
-        catch (const std::exception& e)
+    const int knownCount = m_pageCount.load();
+    for (int page : pages)
+    {
+        if (page < 0 || page >= knownCount || m_pageCache.containsArgb(PageCache::Key(page, scale)))
         {
-            std::cerr << "Background prerendering failed: " << e.what() << std::endl;
+            continue;
         }
 
-        m_prerenderActive = false; });
+        RenderWorkerPool::JobKey key;
+        key.kind = JOB_PRERENDER;
+        key.page = page;
+        key.scale = scale;
+        m_renderPool.submit(RenderWorkerPool::Priority::Neighbor, key, [this, page, scale, generation]()
+                            { prerenderPageInternal(page, scale, generation); });
+    }
+    return true;
 }
 
 void MuPdfDocument::setUserCSSBeforeOpen(const std::string& css)
@@ -1113,6 +2199,7 @@ void MuPdfDocument::resetDisplayCache()
 {
     std::lock_guard<std::mutex> lock(m_pageDataMutex);
     m_pageDisplayData.clear();
+    m_displayListBytes = 0;
     int pageCount = m_pageCount.load();
     if (pageCount > 0)
     {
@@ -1121,12 +2208,13 @@ void MuPdfDocument::resetDisplayCache()
     m_dimensionCache.clear();
 }
 
-void MuPdfDocument::ensureDisplayList(int pageNumber)
+void MuPdfDocument::ensureDisplayList(int pageNumber, fz_cookie* cookie)
 {
     {
         std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
         if (pageNumber >= 0 && pageNumber < static_cast<int>(m_pageDisplayData.size()) && m_pageDisplayData[pageNumber].displayList)
         {
+            m_pageDisplayData[pageNumber].lastUse = ++m_displayListUseCounter;
             return;
         }
     }
@@ -1142,6 +2230,12 @@ void MuPdfDocument::ensureDisplayList(int pageNumber)
     fz_display_list* list = nullptr;
     fz_device* device = nullptr;
     fz_rect bounds{};
+    size_t listSize = 0;
+    fz_var(listSize);
+    // What this thread still holds once the page is dropped is the list plus
+    // the fonts and images it keeps alive in the store. Store evictions made
+    // along the way only lower the figure.
+    const int64_t netBytesBefore = MuPdfAllocator::threadNetBytes();
 
     fz_try(ctx)
     {
@@ -1167,13 +2261,22 @@ void MuPdfDocument::ensureDisplayList(int pageNumber)
             fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to create list device for page %d", pageNumber);
         }
 
-        fz_run_page(ctx, page, device, fz_identity, nullptr);
+        fz_run_page(ctx, page, device, fz_identity, cookie);
         fz_close_device(ctx, device);
         fz_drop_device(ctx, device);
         device = nullptr;
 
         fz_drop_page(ctx, page);
         page = nullptr;
+
+        // An aborted run leaves a truncated list that must not be cached
+        if (cookie && cookie->abort)
+        {
+            fz_throw(ctx, FZ_ERROR_GENERIC, "Display list build aborted");
+        }
+
+        const int64_t built = MuPdfAllocator::threadNetBytes() - netBytesBefore;
+        listSize = std::max(MIN_DISPLAY_LIST_BYTES, built > 0 ? static_cast<size_t>(built) : size_t{0});
     }
     fz_catch(ctx)
     {
@@ -1208,8 +2311,48 @@ void MuPdfDocument::ensureDisplayList(int pageNumber)
         {
             entry.displayList = std::move(listPtr);
             entry.bounds = bounds;
+            entry.bytes = listSize;
+            m_displayListBytes += listSize;
+            ++m_displayListBuilds;
         }
+        entry.lastUse = ++m_displayListUseCounter;
+        recordPageBoundsLocked(pageNumber, bounds);
         // If another thread already populated the entry, listPtr will fall out of scope and release resources.
+
+        evictDisplayListsLocked(pageNumber);
+    }
+}
+
+void MuPdfDocument::evictDisplayListsLocked(int keepPage)
+{
+    // Callers hold m_renderMutex as well: every user of a list pointer either
+    // holds it or took its own reference (prerender), so dropping is safe here
+    const int focus = m_focusPage.load();
+    while (m_displayListBytes > m_displayListBudget)
+    {
+        PageDisplayData* victim = nullptr;
+        for (size_t i = 0; i < m_pageDisplayData.size(); ++i)
+        {
+            auto& entry = m_pageDisplayData[i];
+            const int page = static_cast<int>(i);
+            if (!entry.displayList || page == keepPage || std::abs(page - focus) <= PINNED_DISPLAY_LIST_RADIUS)
+            {
+                continue;
+            }
+            if (!victim || entry.lastUse < victim->lastUse)
+            {
+                victim = &entry;
+            }
+        }
+        if (!victim)
+        {
+            return; // Everything left is pinned
+        }
+
+        m_displayListBytes -= std::min(m_displayListBytes, victim->bytes);
+        victim->displayList.reset();
+        victim->bytes = 0;
+        ++m_displayListEvictions;
     }
 }
 
@@ -1234,6 +2377,20 @@ MuPdfDocument::PageScaleInfo MuPdfDocument::computePageScaleInfoLocked(int pageN
         throw std::runtime_error("Display list missing for page " + std::to_string(pageNumber));
     }
 
+    computeScaleGeometry(info, zoom);
+
+    {
+        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+        m_dimensionCache[dimensionKey] = {info.width, info.height};
+    }
+
+    return info;
+}
+
+void MuPdfDocument::computeScaleGeometry(PageScaleInfo& info, int zoom) const
+{
+    info.baseScale = std::max(zoom, 1) / 100.0f;
+
     int nativeWidth = static_cast<int>(std::round(info.bounds.x1 - info.bounds.x0));
     int nativeHeight = static_cast<int>(std::round(info.bounds.y1 - info.bounds.y0));
     nativeWidth = std::max(nativeWidth, 1);
@@ -1242,8 +2399,9 @@ MuPdfDocument::PageScaleInfo MuPdfDocument::computePageScaleInfoLocked(int pageN
     int scaledWidth = static_cast<int>(std::round(nativeWidth * info.baseScale));
     int scaledHeight = static_cast<int>(std::round(nativeHeight * info.baseScale));
 
+    // Tiled zoom levels only rasterize what is visible, so they keep full resolution
     info.downsampleScale = 1.0f;
-    if (scaledWidth > m_maxWidth || scaledHeight > m_maxHeight)
+    if (!shouldUseTiledRendering(zoom) && (scaledWidth > m_maxWidth || scaledHeight > m_maxHeight))
     {
         float scaleX = static_cast<float>(m_maxWidth) / std::max(scaledWidth, 1);
         float scaleY = static_cast<float>(m_maxHeight) / std::max(scaledHeight, 1);
@@ -1265,274 +2423,456 @@ MuPdfDocument::PageScaleInfo MuPdfDocument::computePageScaleInfoLocked(int pageN
     info.bbox = fz_round_rect(transformed);
     info.width = std::max(1, info.bbox.x1 - info.bbox.x0);
     info.height = std::max(1, info.bbox.y1 - info.bbox.y0);
+}
 
+bool MuPdfDocument::knownPageBounds(int pageNumber, fz_rect& bounds)
+{
+    std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+    if (pageNumber < 0 || pageNumber >= static_cast<int>(m_knownPageBounds.size()) ||
+        fz_is_empty_rect(m_knownPageBounds[pageNumber]))
     {
-        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
-        m_dimensionCache[dimensionKey] = {info.width, info.height};
+        return false;
     }
-
-    return info;
+    bounds = m_knownPageBounds[pageNumber];
+    return true;
 }
 
-void MuPdfDocument::joinAsyncRenderThread()
+void MuPdfDocument::recordPageBoundsLocked(int pageNumber, const fz_rect& bounds)
 {
+    if (pageNumber >= static_cast<int>(m_knownPageBounds.size()))
     {
-        std::lock_guard<std::mutex> lock(m_asyncRenderMutex);
-        m_asyncShutdown = true;
-        m_asyncRenderQueue.clear();
+        m_knownPageBounds.resize(static_cast<size_t>(pageNumber) + 1, fz_empty_rect);
     }
-    m_asyncRenderCv.notify_all();
 
-    if (m_asyncRenderThread.joinable())
+    fz_rect& known = m_knownPageBounds[pageNumber];
+    if (known.x0 != bounds.x0 || known.y0 != bounds.y0 || known.x1 != bounds.x1 || known.y1 != bounds.y1)
     {
-        m_asyncRenderThread.join();
+        known = bounds;
+        m_metadataDirty.store(true);
     }
-
-    m_asyncWorkerRunning = false;
 }
 
-bool MuPdfDocument::isRenderableQueued(const std::pair<int, int>& key)
+void MuPdfDocument::saveMetadata()
 {
-    for (const auto& pending : m_asyncRenderQueue)
+    if (m_documentIdentity.empty() || !m_metadataDirty.exchange(false))
+    {
+        return;
+    }
+
+    DocumentMetadata metadata;
+    // Only a real fz_count_pages result is worth persisting, not an estimate
+    if (m_pageCountCounted.load() && m_pageCountFinal.load())
+    {
+        metadata.pageCount = m_pageCount.load();
+    }
     {
-        if (pending == key)
+        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+        metadata.bounds.resize(m_knownPageBounds.size());
+        for (size_t i = 0; i < m_knownPageBounds.size(); ++i)
         {
-            return true;
+            const fz_rect& known = m_knownPageBounds[i];
+            if (!fz_is_empty_rect(known))
+            {
+                metadata.bounds[i] = DocumentMetadata::PageBounds{known.x0, known.y0, known.x1, known.y1};
+            }
         }
     }
-    return false;
+
+    std::lock_guard<std::mutex> lock(m_metadataMutex);
+    saveDocumentMetadata(m_documentIdentity, m_metadataCss, metadata);
 }
 
-bool MuPdfDocument::renderPageARGBWithPrerenderContext(int pageNumber, int zoom, std::vector<uint32_t>& buffer,
-                                                       int& width, int& height)
+unsigned char MuPdfDocument::pageClearValue() const
 {
-    std::unique_lock<std::mutex> lock(m_prerenderMutex);
-
-    if (!m_prerenderCtx || !m_prerenderDoc)
+    // PDF content expects a white canvas; other formats can inherit themed backgrounds
+    if (m_isPdfDocument)
     {
-        return false;
+        return 255;
     }
+    return static_cast<unsigned char>((m_bgR + m_bgG + m_bgB) / 3);
+}
 
-    fz_context* ctx = m_prerenderCtx.get();
-    fz_document* doc = m_prerenderDoc.get();
+PixelBufferPool::BufferPtr MuPdfDocument::rasterizeDisplayListARGB(fz_context* ctx, fz_display_list* list,
+                                                                   const fz_matrix& transform, const fz_irect& bbox,
+                                                                   int pageNumber, fz_cookie* cookie, bool allowBanding)
+{
+    const int width = std::max(1, bbox.x1 - bbox.x0);
+    const int height = std::max(1, bbox.y1 - bbox.y0);
+
+    // Every pixel is written, so a recycled buffer needs no clearing
+    PixelBufferPool::BufferPtr argbBuffer =
+        PixelBufferPool::shared().acquire(static_cast<size_t>(width) * static_cast<size_t>(height));
+    rasterizeDisplayListInto(ctx, list, transform, bbox, pageNumber, argbBuffer->data(), width, cookie, allowBanding);
+    return argbBuffer;
+}
 
-    fz_page* page = nullptr;
-    fz_device* dev = nullptr;
-    fz_pixmap* pix = nullptr;
-    fz_var(page);
-    fz_var(dev);
-    fz_var(pix);
-    std::vector<uint32_t> localBuffer;
-    bool ok = true;
-    fz_var(ok);
+void MuPdfDocument::rasterizeDisplayListInto(fz_context* ctx, fz_display_list* list, const fz_matrix& transform,
+                                             const fz_irect& bbox, int pageNumber, uint32_t* dest, int destStride,
+                                             fz_cookie* cookie, bool allowBanding)
+{
+    const int width = std::max(1, bbox.x1 - bbox.x0);
+    const int height = std::max(1, bbox.y1 - bbox.y0);
+    const unsigned char clearValue = pageClearValue();
+    const auto startTime = std::chrono::steady_clock::now();
 
-    fz_try(ctx)
+    // Split the page into horizontal bands and rasterize them in parallel on
+    // cloned contexts. The display list is immutable, so every band can replay
+    // it; each band writes only its own rows of dest.
+    int bandCount = allowBanding ? rasterBandCount(width, height) : 1;
+    if (bandCount > 1)
     {
-        page = fz_load_page(ctx, doc, pageNumber);
-        if (!page)
-        {
-            fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to load page %d", pageNumber);
-        }
-        fz_rect bounds = fz_bound_page(ctx, page);
-
-        float baseScale = std::max(zoom, 1) / 100.0f;
-        int nativeWidth = std::max(1, static_cast<int>(std::round(bounds.x1 - bounds.x0)));
-        int nativeHeight = std::max(1, static_cast<int>(std::round(bounds.y1 - bounds.y0)));
-
-        int scaledWidth = std::max(1, static_cast<int>(std::round(nativeWidth * baseScale)));
-        int scaledHeight = std::max(1, static_cast<int>(std::round(nativeHeight * baseScale)));
-
-        float downsampleScale = 1.0f;
-        if (scaledWidth > m_maxWidth || scaledHeight > m_maxHeight)
-        {
-            float scaleX = static_cast<float>(m_maxWidth) / std::max(scaledWidth, 1);
-            float scaleY = static_cast<float>(m_maxHeight) / std::max(scaledHeight, 1);
-            downsampleScale = std::min(scaleX, scaleY);
-
-            if (baseScale > 1.5f)
-            {
-                float extraDetail = std::min(baseScale - 1.5f, 0.5f) * 0.1f;
-                downsampleScale = std::min(downsampleScale * (1.0f + extraDetail), 1.0f);
-            }
-        }
+        bandCount = ensureRasterContextsLocked(ctx, bandCount);
+    }
+    if (bandCount < 1)
+    {
+        bandCount = 1;
+    }
 
-        float finalScale = baseScale * downsampleScale;
-        fz_matrix transform = fz_scale(finalScale, finalScale);
-        fz_rect transformed = fz_transform_rect(bounds, transform);
-        fz_irect bbox = fz_round_rect(transformed);
+    const int bandRows = (height + bandCount - 1) / bandCount;
+    std::vector<std::string> bandErrors(static_cast<size_t>(bandCount));
+    std::vector<char> bandOk(static_cast<size_t>(bandCount), 0);
+    // Cookies carry per-run progress, so each band gets its own; the caller's
+    // cookie is watched below and its abort forwarded to all of them. A page
+    // drawn in one piece runs on the caller's context and cookie.
+    std::vector<fz_cookie> bandCookies(static_cast<size_t>(bandCount));
+    const bool banded = bandCount > 1;
 
-        width = std::max(1, bbox.x1 - bbox.x0);
-        height = std::max(1, bbox.y1 - bbox.y0);
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    int remaining = bandCount;
 
-        pix = fz_new_pixmap_with_bbox(ctx, fz_device_rgb(ctx), bbox, nullptr, 1);
-        if (!pix)
+    auto renderBand = [&](int band)
+    {
+        fz_context* bandCtx = banded ? m_rasterContexts[band].get() : ctx;
+        if (banded)
         {
-            fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to allocate pixmap for page %d", pageNumber);
+            // Clones keep the anti-aliasing they were cloned with; follow the caller's
+            fz_set_text_aa_level(bandCtx, fz_text_aa_level(ctx));
+            fz_set_graphics_aa_level(bandCtx, fz_graphics_aa_level(ctx));
         }
 
-        // Match the primary render path: keep PDFs on a white canvas
-        unsigned char clearValue = 255;
-        if (!m_isPdfDocument)
+        fz_irect bandBox = bbox;
+        bandBox.x1 = bbox.x0 + width;
+        bandBox.y0 = bbox.y0 + band * bandRows;
+        bandBox.y1 = std::min(bbox.y0 + height, bandBox.y0 + bandRows);
+        if (bandBox.y1 <= bandBox.y0)
         {
-            clearValue = static_cast<unsigned char>((m_bgR + m_bgG + m_bgB) / 3);
+            bandOk[band] = 1;
         }
-        fz_clear_pixmap_with_value(ctx, pix, clearValue);
-
-        dev = fz_new_draw_device(ctx, fz_identity, pix);
-        if (!dev)
+        else
         {
-            fz_drop_pixmap(ctx, pix);
-            pix = nullptr;
-            fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to create draw device for page %d", pageNumber);
+            uint32_t* destRows = dest + static_cast<size_t>(band) * bandRows * destStride;
+            bandOk[band] = rasterizeBandARGB(bandCtx, list, transform, bandBox, clearValue, destRows, width,
+                                             destStride, banded ? &bandCookies[band] : cookie,
+                                             bandErrors[band])
+                               ? 1
+                               : 0;
         }
 
-        fz_run_page(ctx, page, dev, transform, nullptr);
-        fz_close_device(ctx, dev);
-        fz_drop_device(ctx, dev);
-        dev = nullptr;
+        std::lock_guard<std::mutex> lock(doneMutex);
+        --remaining;
+        doneCv.notify_one();
+    };
 
-        localBuffer.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
-        const unsigned char* samples = fz_pixmap_samples(ctx, pix);
-        int stride = fz_pixmap_stride(ctx, pix);
+    if (!banded)
+    {
+        renderBand(0);
+    }
+    else
+    {
+        // Bands run on the persistent band workers; this thread only waits.
+        // Only one banded raster runs at a time (m_renderMutex); the serial
+        // keeps the keys apart from the previous call's jobs, which may still
+        // be winding down in the pool.
+        const int serial = static_cast<int>(++m_bandSerial & 0x7fffffff);
+        for (int band = 0; band < bandCount; ++band)
+        {
+            RenderWorkerPool::JobKey key;
+            key.kind = JOB_RASTER_BAND;
+            key.page = pageNumber;
+            key.tileX = band;
+            key.tileY = serial;
+            if (!m_bandPool.submit(RenderWorkerPool::Priority::Visible, key, [&renderBand, band]()
+                                   { renderBand(band); }))
+            {
+                renderBand(band); // Pool shut down with the document; finish here
+            }
+        }
+    }
 
-        if (!samples || stride <= 0 || stride < width * 4)
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        while (remaining > 0)
         {
-            if (pix)
+            doneCv.wait_for(lock, BAND_ABORT_POLL_INTERVAL);
+            if (!cookie)
             {
-                fz_drop_pixmap(ctx, pix);
-                pix = nullptr;
+                continue;
             }
-            if (page)
+            size_t progress = 0;
+            size_t progressMax = 0;
+            for (fz_cookie& bandCookie : bandCookies)
             {
-                fz_drop_page(ctx, page);
-                page = nullptr;
+                if (cookie->abort)
+                {
+                    bandCookie.abort = 1;
+                }
+                progress += static_cast<size_t>(loadCookieField(bandCookie.progress));
+                const size_t bandMax = loadCookieField(bandCookie.progress_max);
+                progressMax += bandMax == static_cast<size_t>(-1) ? 0 : bandMax;
             }
-            fz_throw(ctx, FZ_ERROR_GENERIC, "Invalid pixmap data for page %d (samples=%p, stride=%d, width=%d)",
-                     pageNumber, static_cast<const void*>(samples), stride, width);
+            storeCookieField(cookie->progress, static_cast<int>(progress));
+            storeCookieField(cookie->progress_max, progressMax);
         }
+    }
 
-        for (int y = 0; y < height; ++y)
+    if (cookie && cookie->abort)
+    {
+        throw std::runtime_error("Render of page " + std::to_string(pageNumber) + " aborted");
+    }
+
+    for (int band = 0; band < bandCount; ++band)
+    {
+        if (!bandOk[band])
         {
-            const unsigned char* srcRow = samples + static_cast<size_t>(y) * stride;
-            for (int x = 0; x < width; ++x)
+            std::string message = "Error rendering page " + std::to_string(pageNumber);
+            if (!bandErrors[band].empty())
             {
-                const unsigned char* srcPixel = srcRow + static_cast<size_t>(x) * 4;
-                uint32_t r = static_cast<uint32_t>(srcPixel[0]);
-                uint32_t g = static_cast<uint32_t>(srcPixel[1]);
-                uint32_t b = static_cast<uint32_t>(srcPixel[2]);
-                uint32_t a = static_cast<uint32_t>(srcPixel[3]);
-                localBuffer[static_cast<size_t>(y) * width + x] = (a << 24) | (r << 16) | (g << 8) | b;
+                message += ": ";
+                message += bandErrors[band];
             }
+            std::cerr << "MuPdfDocument: " << message << std::endl;
+            throw std::runtime_error(message);
         }
-        fz_drop_pixmap(ctx, pix);
-        pix = nullptr;
-        fz_drop_page(ctx, page);
-        page = nullptr;
     }
-    fz_catch(ctx)
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - startTime)
+                               .count();
+    if (elapsedMs >= SLOW_RASTER_LOG_MS)
     {
-        ok = false;
+        std::cout << "MuPdfDocument: rasterized page " << pageNumber << " (" << width << "x" << height << ") in "
+                  << elapsedMs << " ms using " << bandCount << (bandCount == 1 ? " band" : " bands") << std::endl;
+    }
+}
 
-        if (dev)
-            fz_drop_device(ctx, dev);
-        if (pix)
-            fz_drop_pixmap(ctx, pix);
-        if (page)
-            fz_drop_page(ctx, page);
+int MuPdfDocument::rasterBandCount(int width, int height) const
+{
+    if (static_cast<size_t>(width) * static_cast<size_t>(height) < MIN_BANDED_RASTER_PIXELS)
+    {
+        return 1;
     }
 
-    lock.unlock();
+    int bands = std::min(maxRasterBands(), height / MIN_RASTER_BAND_ROWS);
+    return std::max(1, bands);
+}
 
-    if (!ok)
+int MuPdfDocument::ensureRasterContextsLocked(fz_context* ctx, int count)
+{
+    // Clones are tied to the context they were made from; reopening with a
+    // fresh context invalidates them.
+    if (m_rasterContextsBase != ctx)
     {
-        return false;
+        m_rasterContexts.clear();
+        m_rasterContextsBase = ctx;
     }
 
-    buffer = std::move(localBuffer);
+    while (static_cast<int>(m_rasterContexts.size()) < count)
+    {
+        fz_context* clone = fz_clone_context(ctx);
+        if (!clone)
+        {
+            std::cerr << "MuPdfDocument: Failed to clone context for banded rendering, using "
+                      << (m_rasterContexts.size() + 1) << " band(s)" << std::endl;
+            break;
+        }
+        m_rasterContexts.emplace_back(clone);
+    }
 
-    return true;
+    return std::min(count, static_cast<int>(m_rasterContexts.size()));
 }
 
-void MuPdfDocument::asyncRenderWorker()
+fz_context* MuPdfDocument::acquireWorkerRasterContextLocked()
 {
-    while (true)
+    fz_context* base = m_ctx.get();
+    if (!base)
     {
-        std::pair<int, int> task{-1, 0};
+        return nullptr;
+    }
 
+    fz_context* clone = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_workerRasterMutex);
+        if (m_workerRasterBase != base)
         {
-            std::unique_lock<std::mutex> lock(m_asyncRenderMutex);
-            m_asyncRenderCv.wait(lock, [this]()
-                                 { return m_asyncShutdown || !m_asyncRenderQueue.empty(); });
-
-            if ((m_asyncShutdown && m_asyncRenderQueue.empty()))
-            {
-                m_asyncWorkerRunning = false;
-                return;
-            }
-
-            task = m_asyncRenderQueue.front();
-            m_asyncRenderQueue.pop_front();
+            m_idleRasterContexts.clear();
+            m_workerRasterBase = base;
         }
-
-        if (task.first < 0)
+        if (!m_idleRasterContexts.empty())
         {
-            continue;
+            clone = m_idleRasterContexts.back().release();
+            m_idleRasterContexts.pop_back();
         }
+    }
 
-        auto key = std::make_pair(task.first, task.second);
-
+    if (!clone)
+    {
+        clone = fz_clone_context(base);
+        if (!clone)
         {
-            std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-            if (m_argbCache.find(key) != m_argbCache.end())
-            {
-                continue; // Already cached, skip expensive render
-            }
+            std::cerr << "MuPdfDocument: Failed to clone context for background rasterization" << std::endl;
+            return nullptr;
         }
+    }
 
-        std::vector<uint32_t> asyncBuffer;
-        int tmpW = 0;
-        int tmpH = 0;
+    // m_ctx is at its normal anti-aliasing outside a draft render; a clone
+    // made or last used around a setting change follows it here
+    fz_set_text_aa_level(clone, fz_text_aa_level(base));
+    fz_set_graphics_aa_level(clone, fz_graphics_aa_level(base));
+    return clone;
+}
 
-        if (!renderPageARGBWithPrerenderContext(task.first, task.second, asyncBuffer, tmpW, tmpH))
-        {
-            continue;
-        }
+void MuPdfDocument::releaseWorkerRasterContext(fz_context* clone)
+{
+    if (!clone)
+    {
+        return;
+    }
 
-        if (asyncBuffer.empty() || tmpW <= 0 || tmpH <= 0)
-        {
-            continue;
-        }
+    std::unique_ptr<fz_context, CloneDeleter> owned(clone);
+    std::lock_guard<std::mutex> lock(m_workerRasterMutex);
+    // Dropped instead if the resources were released meanwhile
+    if (m_workerRasterBase)
+    {
+        m_idleRasterContexts.push_back(std::move(owned));
+    }
+}
 
-        auto bufferPtr = std::make_shared<std::vector<uint32_t>>(std::move(asyncBuffer));
+void MuPdfDocument::releaseMuPdfResources()
+{
+    // Clones and display lists hold references into the context's store, so
+    // they go first; the context is only reset once nothing uses it
+    m_rasterContexts.clear();
+    m_rasterContextsBase = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_workerRasterMutex);
+        m_idleRasterContexts.clear();
+        m_workerRasterBase = nullptr;
+    }
+    resetDisplayCache();
+    m_doc.reset();
+    m_ctx.reset();
+}
 
-        {
-            std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
-#ifdef TRIMUI_PLATFORM
-            if (m_argbCache.size() >= 2)
-            {
-#else
-            if (m_argbCache.size() >= 5)
-            {
-#endif
-                m_argbCache.erase(m_argbCache.begin());
-            }
+void MuPdfDocument::drainRenderPool()
+{
+    // Block new submissions, drop queued work and wait for running jobs, but
+    // keep the workers alive for the next document.
+    m_asyncShutdown = true;
+    m_renderPool.cancelAll();
+    m_renderPool.wait([](const RenderWorkerPool::JobKey&)
+                      { return true; });
+}
+
+void MuPdfDocument::renderPageAsyncJob(int pageNumber, int scale, uint64_t generationToken)
+{
+    // The UI shows a stretched preview before it looks at the disk cache, so a
+    // page from an earlier session is picked up here, off the UI thread
+    ArgbBufferPtr cached;
+    int width = 0;
+    int height = 0;
+    if (!isPrerenderRequestStale(generationToken) && tryLoadPageFromDiskCache(pageNumber, scale, cached, width, height))
+    {
+        return;
+    }
 
-            m_argbCache[key] = std::make_tuple(bufferPtr, tmpW, tmpH);
+    // Same path as a prerender: interpret into the shared display list, then
+    // rasterize on a clone of the main context
+    prerenderPageInternal(pageNumber, scale, generationToken);
+}
+
+bool MuPdfDocument::isPrerenderRequestStale(uint64_t generationToken) const
+{
+    return generationToken != m_prerenderGeneration.load(std::memory_order_relaxed);
+}
+
+MuPdfDocument::ScopedRenderCookie::ScopedRenderCookie(MuPdfDocument& owner, uint64_t generation, int page)
+    : m_owner(owner), m_page(page), m_start(std::chrono::steady_clock::now())
+{
+    std::lock_guard<std::mutex> lock(m_owner.m_cookieMutex);
+    m_owner.m_activeCookies.push_back({&m_cookie, generation, page, m_start});
+    // The generation may have moved on before we registered
+    if (m_owner.isPrerenderRequestStale(generation))
+    {
+        m_cookie.abort = 1;
+    }
+}
+
+MuPdfDocument::ScopedRenderCookie::~ScopedRenderCookie()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_owner.m_cookieMutex);
+        auto& cookies = m_owner.m_activeCookies;
+        cookies.erase(std::remove_if(cookies.begin(), cookies.end(), [this](const ActiveCookie& active)
+                                     { return active.cookie == &m_cookie; }),
+                      cookies.end());
+    }
+
+    // Where a slow page stopped tells a pathological page from a stuck one
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - m_start)
+                               .count();
+    if (m_page >= 0 && elapsedMs >= SLOW_RASTER_LOG_MS)
+    {
+        std::cout << "MuPdfDocument: background render of page " << m_page << " took " << elapsedMs
+                  << " ms, progress " << m_cookie.progress;
+        if (m_cookie.progress_max > 0 && m_cookie.progress_max != static_cast<size_t>(-1))
+        {
+            std::cout << "/" << m_cookie.progress_max;
+        }
+        if (m_cookie.abort)
+        {
+            std::cout << " (aborted)";
         }
+        std::cout << std::endl;
+    }
+}
 
+MuPdfDocument::RenderProgress MuPdfDocument::getRenderProgress(int page) const
+{
+    RenderProgress result;
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_cookieMutex);
+    for (const auto& active : m_activeCookies)
+    {
+        if (active.page != page || active.cookie->abort)
         {
-            std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
-            m_dimensionCache[key] = {tmpW, tmpH};
+            continue;
         }
+        result.active = true;
+        result.progress = loadCookieField(active.cookie->progress);
+        const size_t progressMax = loadCookieField(active.cookie->progress_max);
+        result.progressMax = progressMax == static_cast<size_t>(-1) ? 0 : progressMax;
+        result.elapsedMs = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - active.start).count());
+        break;
     }
+    return result;
 }
 
-bool MuPdfDocument::isPrerenderRequestStale(uint64_t generationToken) const
+void MuPdfDocument::abortStaleRenderCookies(uint64_t currentGeneration)
 {
-    return generationToken != m_prerenderGeneration.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_cookieMutex);
+    for (auto& active : m_activeCookies)
+    {
+        if (active.generation != currentGeneration)
+        {
+            active.cookie->abort = 1;
+        }
+    }
 }
 
-void MuPdfDocument::prerenderPageInternal(int pageNumber, int scale, uint64_t generationToken)
+void MuPdfDocument::prerenderPageInternal(int pageNumber, int scale, uint64_t generationToken, bool toDiskCache)
 {
     if (isPrerenderRequestStale(generationToken))
     {
@@ -1556,158 +2896,91 @@ void MuPdfDocument::prerenderPageInternal(int pageNumber, int scale, uint64_t ge
         return;
     }
 
-    auto key = std::make_pair(pageNumber, scale);
+    PageCache::Key key(pageNumber, scale);
+    if (m_pageCache.containsArgb(key))
     {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-        if (m_cache.find(key) != m_cache.end() || m_argbCache.find(key) != m_argbCache.end())
-        {
-            return; // Already cached
-        }
+        return; // Already cached
     }
 
-    std::lock_guard<std::mutex> prerenderLock(m_prerenderMutex);
-
-    if (!m_prerenderCtx || !m_prerenderDoc || isPrerenderRequestStale(generationToken))
-    {
-        return;
-    }
-
-    fz_context* ctx = m_prerenderCtx.get();
-    fz_document* doc = m_prerenderDoc.get();
+    ScopedRenderCookie cookie(*this, generationToken, pageNumber);
+    fz_context* rasterCtx = nullptr;
+    fz_display_list* list = nullptr;
+    PageScaleInfo scaleInfo{};
 
-    try
+    // Interpret the page into the shared display list (the same one the
+    // foreground path uses) while holding the document lock, then rasterize
+    // on a context of our own so the UI thread and the other workers can
+    // render meanwhile.
     {
-        float baseScale = scale / 100.0f;
-        float downsampleScale = 1.0f;
-        fz_var(downsampleScale);
-
-        fz_page* tempPage = nullptr;
-        fz_var(tempPage);
-        bool prerenderBoundsError = false;
-        fz_var(prerenderBoundsError);
-
-        fz_try(ctx)
-        {
-            tempPage = fz_load_page(ctx, doc, pageNumber);
-            if (!tempPage)
-            {
-                fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to load page for prerender");
-            }
-
-            if (isPrerenderRequestStale(generationToken))
-            {
-                fz_drop_page(ctx, tempPage);
-                tempPage = nullptr;
-                fz_throw(ctx, FZ_ERROR_GENERIC, "Prerender request stale");
-            }
-
-            fz_rect bounds = fz_bound_page(ctx, tempPage);
-            int nativeWidth = static_cast<int>((bounds.x1 - bounds.x0) * baseScale);
-            int nativeHeight = static_cast<int>((bounds.y1 - bounds.y0) * baseScale);
-
-            if (nativeWidth > m_maxWidth || nativeHeight > m_maxHeight)
-            {
-                float scaleX = static_cast<float>(m_maxWidth) / std::max(nativeWidth, 1);
-                float scaleY = static_cast<float>(m_maxHeight) / std::max(nativeHeight, 1);
-                downsampleScale = std::min(scaleX, scaleY);
-
-                if (baseScale > 1.5f)
-                {
-                    float extraDetail = std::min(baseScale - 1.5f, 0.5f) * 0.1f;
-                    downsampleScale = std::min(downsampleScale * (1.0f + extraDetail), 1.0f);
-                }
-            }
-            fz_drop_page(ctx, tempPage);
-            tempPage = nullptr;
-        }
-        fz_catch(ctx)
+        std::lock_guard<std::mutex> renderLock(m_renderMutex);
+        if (!m_ctx || !m_doc || isPrerenderRequestStale(generationToken))
         {
-            if (tempPage)
-                fz_drop_page(ctx, tempPage);
-            prerenderBoundsError = true;
+            return;
         }
 
-        if (prerenderBoundsError || isPrerenderRequestStale(generationToken))
+        try
         {
-            return;
+            ensureDisplayList(pageNumber, cookie.get());
+            scaleInfo = computePageScaleInfoLocked(pageNumber, scale);
         }
-
-        fz_matrix transform = fz_scale(baseScale * downsampleScale, baseScale * downsampleScale);
-        fz_pixmap* pix = nullptr;
-        fz_var(pix);
-        std::vector<unsigned char> buffer;
-
-        bool prerenderError = false;
-        std::string prerenderErrorMsg;
-        const char* prerenderMuPdfMsg = nullptr;
-        fz_var(prerenderError);
-        fz_var(prerenderMuPdfMsg);
-
-        fz_try(ctx)
+        catch (const std::exception& e)
         {
-            fz_page* page = fz_load_page(ctx, doc, pageNumber);
-            fz_var(page);
-            if (!page)
+            if (!cookie.aborted())
             {
-                fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to load page %d for prerendering", pageNumber);
+                std::cerr << "MuPdfDocument: Error prerendering page " << pageNumber << ": " << e.what() << std::endl;
             }
+            return;
+        }
 
-            if (isPrerenderRequestStale(generationToken))
-            {
-                fz_drop_page(ctx, page);
-                fz_throw(ctx, FZ_ERROR_GENERIC, "Prerender request stale");
-            }
-
-            pix = fz_new_pixmap_from_page(ctx, page, transform, fz_device_rgb(ctx), 0);
-            if (!pix)
-            {
-                fz_drop_page(ctx, page);
-                fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to create pixmap for prerender page %d", pageNumber);
-            }
-
-            fz_drop_page(ctx, page);
-
-            int w = fz_pixmap_width(ctx, pix);
-            int h = fz_pixmap_height(ctx, pix);
-
-            size_t dataSize = static_cast<size_t>(w) * static_cast<size_t>(h) * 3;
-            buffer.resize(dataSize);
-            memcpy(buffer.data(), fz_pixmap_samples(ctx, pix), dataSize);
-
-            fz_drop_pixmap(ctx, pix);
-            pix = nullptr;
-
-            if (!isPrerenderRequestStale(generationToken))
-            {
-                std::lock_guard<std::mutex> lock(m_cacheMutex);
-                m_cache[key] = std::make_tuple(buffer, w, h);
-            }
+        if (!scaleInfo.displayList)
+        {
+            return;
         }
-        fz_catch(ctx)
+        rasterCtx = acquireWorkerRasterContextLocked();
+        if (!rasterCtx)
         {
-            if (pix)
-                fz_drop_pixmap(ctx, pix);
-            prerenderError = true;
-            prerenderErrorMsg = "Error prerendering page " + std::to_string(pageNumber);
-            prerenderMuPdfMsg = fz_caught_message(ctx);
+            return;
         }
+        // Keep the list alive even if the display cache is reset while we rasterize
+        list = fz_keep_display_list(m_ctx.get(), scaleInfo.displayList);
+    }
 
-        if (prerenderError)
+    PixelBufferPool::BufferPtr argbBuffer;
+    bool ok = false;
+    try
+    {
+        // Background work stays on one core per job; the other workers need theirs
+        argbBuffer = rasterizeDisplayListARGB(rasterCtx, list, scaleInfo.transform, scaleInfo.bbox, pageNumber,
+                                              cookie.get(), false);
+        ok = true;
+    }
+    catch (const std::exception& e)
+    {
+        if (!cookie.aborted())
         {
-            bool isStale = prerenderMuPdfMsg && strstr(prerenderMuPdfMsg, "Prerender request stale");
-            if (!isStale)
-            {
-                if (prerenderMuPdfMsg && strlen(prerenderMuPdfMsg) > 0)
-                {
-                    prerenderErrorMsg += ": " + std::string(prerenderMuPdfMsg);
-                }
-                std::cerr << "MuPdfDocument: " << prerenderErrorMsg << std::endl;
-            }
+            std::cerr << "Exception during prerender of page " << pageNumber << ": " << e.what() << std::endl;
         }
     }
-    catch (const std::exception& e)
+    fz_drop_display_list(rasterCtx, list);
+    releaseWorkerRasterContext(rasterCtx);
+
+    if (!ok || isPrerenderRequestStale(generationToken))
     {
-        std::cerr << "Exception during prerender of page " << pageNumber << ": " << e.what() << std::endl;
+        return;
+    }
+
+    // Same buffer the foreground path would produce, so showing this page
+    // later only costs a texture upload.
+    ArgbBufferPtr bufferPtr = std::move(argbBuffer);
+    m_pageCache.putArgb(key, bufferPtr, scaleInfo.width, scaleInfo.height);
+    if (toDiskCache)
+    {
+        queueDiskCacheWrite(pageNumber, scale, bufferPtr, scaleInfo.width, scaleInfo.height);
+    }
+
+    {
+        std::lock_guard<std::mutex> dataLock(m_pageDataMutex);
+        m_dimensionCache[std::make_pair(pageNumber, scale)] = {scaleInfo.width, scaleInfo.height};
     }
 }
 
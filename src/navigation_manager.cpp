@@ -64,6 +64,7 @@ void NavigationManager::performPageChange(int newPage, Document* document, Viewp
                                           std::function<void()> markDirtyCallback, std::function<void()> updateScaleDisplayCallback,
                                           std::function<void()> updatePageDisplayCallback)
 {
+    m_prefetchPredictor.recordPageChange(m_state.currentPage, newPage, SDL_GetTicks());
     m_state.currentPage = newPage;
 
     if (viewportManager)
@@ -229,5 +230,9 @@ void NavigationManager::printNavigationState() const
     std::cout << "In Page Change Cooldown: " << (isInPageChangeCooldown() ? "Yes" : "No") << std::endl;
     std::cout << "Last Render Duration: " << m_state.lastRenderDuration << "ms" << std::endl;
     std::cout << "Next Render Likely Expensive: " << (isNextRenderLikelyExpensive() ? "Yes" : "No") << std::endl;
+    PrefetchPredictor::Stats prefetch = m_prefetchPredictor.getStats();
+    std::cout << "Prefetch: " << (prefetch.direction < 0 ? "backward" : "forward") << ", depth " << prefetch.depth
+              << ", hit rate " << static_cast<int>(prefetch.hitRate() * 100.0 + 0.5) << "% (" << prefetch.hits << "/"
+              << (prefetch.hits + prefetch.misses) << ")" << std::endl;
     std::cout << "------------------------" << std::endl;
 }
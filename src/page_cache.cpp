@@ -0,0 +1,218 @@
+#include "page_cache.h"
+
+namespace
+{
+#ifdef TRIMUI_PLATFORM
+constexpr size_t DEFAULT_PAGE_CACHE_BYTES = 48u << 20; // ~12 fit-to-screen pages on the 1280x720 panel
+#else
+constexpr size_t DEFAULT_PAGE_CACHE_BYTES = 192u << 20;
+#endif
+} // namespace
+
+PageCache::PageCache(size_t budgetBytes)
+    : m_budgetBytes(budgetBytes)
+{
+}
+
+size_t PageCache::defaultBudgetBytes()
+{
+    return DEFAULT_PAGE_CACHE_BYTES;
+}
+
+bool PageCache::find(const Key& key, Entry& entry, Format format)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || (format == Format::Argb && !it->second.entry.argb) ||
+        (format == Format::Rgb && !it->second.entry.rgb))
+    {
+        ++m_misses;
+        return false;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+    entry = it->second.entry;
+    ++m_hits;
+    return true;
+}
+
+bool PageCache::contains(const Key& key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.find(key) != m_entries.end();
+}
+
+bool PageCache::containsArgb(const Key& key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    return it != m_entries.end() && it->second.entry.argb;
+}
+
+void PageCache::putArgb(const Key& key, ArgbBufferPtr buffer, int width, int height)
+{
+    if (!buffer)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Node& node = touchLocked(key);
+    if (node.entry.rgb && (node.entry.width != width || node.entry.height != height))
+    {
+        node.entry.rgb.reset();
+    }
+    node.entry.argb = std::move(buffer);
+    node.entry.width = width;
+    node.entry.height = height;
+    accountLocked(node);
+    evictLocked(key);
+}
+
+void PageCache::putRgb(const Key& key, RgbBufferPtr buffer, int width, int height)
+{
+    if (!buffer)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Node& node = touchLocked(key);
+    if (node.entry.argb && (node.entry.width != width || node.entry.height != height))
+    {
+        node.entry.argb.reset();
+    }
+    node.entry.rgb = std::move(buffer);
+    node.entry.width = width;
+    node.entry.height = height;
+    accountLocked(node);
+    evictLocked(key);
+}
+
+void PageCache::erase(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+
+    m_bytes -= it->second.bytes;
+    m_lru.erase(it->second.lruIt);
+    m_entries.erase(it);
+}
+
+size_t PageCache::eraseIf(const std::function<bool(const Key&)>& predicate)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t erased = 0;
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (!predicate(it->first))
+        {
+            ++it;
+            continue;
+        }
+        m_bytes -= it->second.bytes;
+        m_lru.erase(it->second.lruIt);
+        it = m_entries.erase(it);
+        ++erased;
+    }
+    return erased;
+}
+
+void PageCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_lru.clear();
+    m_bytes = 0;
+}
+
+void PageCache::setBudgetBytes(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budgetBytes = budgetBytes;
+    if (!m_lru.empty())
+    {
+        evictLocked(m_lru.front());
+    }
+}
+
+size_t PageCache::getBudgetBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budgetBytes;
+}
+
+PageCache::Stats PageCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.entries = m_entries.size();
+    stats.bytes = m_bytes;
+    stats.budgetBytes = m_budgetBytes;
+    return stats;
+}
+
+size_t PageCache::entryBytes(const Entry& entry)
+{
+    size_t bytes = 0;
+    if (entry.argb)
+    {
+        bytes += entry.argb->size() * sizeof(uint32_t);
+    }
+    if (entry.rgb)
+    {
+        bytes += entry.rgb->size();
+    }
+    return bytes;
+}
+
+PageCache::Node& PageCache::touchLocked(const Key& key)
+{
+    auto it = m_entries.find(key);
+    if (it != m_entries.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+        return it->second;
+    }
+
+    m_lru.push_front(key);
+    Node& node = m_entries[key];
+    node.lruIt = m_lru.begin();
+    return node;
+}
+
+void PageCache::accountLocked(Node& node)
+{
+    m_bytes -= node.bytes;
+    node.bytes = entryBytes(node.entry);
+    m_bytes += node.bytes;
+}
+
+void PageCache::evictLocked(const Key& keep)
+{
+    while (m_bytes > m_budgetBytes && !m_lru.empty())
+    {
+        const Key victim = m_lru.back();
+        if (victim == keep)
+        {
+            // Only the protected entry is left
+            break;
+        }
+
+        auto it = m_entries.find(victim);
+        if (it != m_entries.end())
+        {
+            m_bytes -= it->second.bytes;
+            m_entries.erase(it);
+        }
+        m_lru.pop_back();
+        ++m_evictions;
+    }
+}
@@ -65,3 +65,13 @@ std::filesystem::path getDefaultHistoryPath()
 {
     return getStateDirectory() / "reading_history.json";
 }
+
+std::filesystem::path getDefaultPageCacheDirectory()
+{
+    return getStateDirectory() / "page_cache";
+}
+
+std::filesystem::path getDefaultMetadataDirectory()
+{
+    return getStateDirectory() / "metadata";
+}
@@ -0,0 +1,178 @@
+#include "pixel_buffer_pool.h"
+#include "page_cache.h"
+
+namespace
+{
+constexpr size_t CLASSES_PER_DOUBLING = 8;
+
+size_t bufferBytes(const std::vector<uint32_t>& buffer)
+{
+    return buffer.capacity() * sizeof(uint32_t);
+}
+} // namespace
+
+PixelBufferPool& PixelBufferPool::shared()
+{
+    // Never destroyed: cached pages may be released during static destruction
+    static PixelBufferPool* pool = new PixelBufferPool();
+    return *pool;
+}
+
+PixelBufferPool::PixelBufferPool()
+    : m_budgetBytes(PageCache::defaultBudgetBytes() / CACHE_BUDGET_DIVISOR)
+{
+}
+
+PixelBufferPool::BufferPtr PixelBufferPool::acquire(size_t pixelCount)
+{
+    if (pixelCount < MIN_POOLED_PIXELS)
+    {
+        return std::make_shared<Buffer>(pixelCount);
+    }
+
+    const size_t capacity = classCapacity(pixelCount);
+    Buffer* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_acquired;
+
+        // Best fit, but never more than two classes up: a page-sized buffer
+        // is not spent on a thumbnail
+        const size_t largest = capacity + capacity / (CLASSES_PER_DOUBLING / 2);
+        auto best = m_idle.end();
+        for (auto it = m_idle.begin(); it != m_idle.end(); ++it)
+        {
+            const size_t idleCapacity = (*it)->capacity();
+            if (idleCapacity >= pixelCount && idleCapacity <= largest &&
+                (best == m_idle.end() || idleCapacity < (*best)->capacity()))
+            {
+                best = it;
+            }
+        }
+        if (best != m_idle.end())
+        {
+            buffer = *best;
+            m_idleBytes -= bufferBytes(*buffer);
+            m_idle.erase(best);
+            ++m_reused;
+        }
+        else
+        {
+            ++m_allocated;
+        }
+    }
+
+    if (!buffer)
+    {
+        buffer = new Buffer();
+        buffer->reserve(capacity);
+    }
+    buffer->resize(pixelCount);
+    return BufferPtr(buffer, Recycler{this});
+}
+
+PixelBufferPool::BufferPtr PixelBufferPool::adopt(Buffer&& pixels)
+{
+    return BufferPtr(new Buffer(std::move(pixels)), Recycler{this});
+}
+
+void PixelBufferPool::setBudgetBytes(size_t budgetBytes)
+{
+    std::vector<Buffer*> released;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budgetBytes = budgetBytes;
+        trimLocked(m_budgetBytes, released);
+    }
+    for (Buffer* buffer : released)
+    {
+        delete buffer;
+    }
+}
+
+void PixelBufferPool::trim(size_t keepBytes)
+{
+    std::vector<Buffer*> released;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        trimLocked(keepBytes, released);
+    }
+    for (Buffer* buffer : released)
+    {
+        delete buffer;
+    }
+}
+
+PixelBufferPool::Stats PixelBufferPool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.acquired = m_acquired;
+    stats.reused = m_reused;
+    stats.allocated = m_allocated;
+    stats.released = m_released;
+    stats.idleBuffers = m_idle.size();
+    stats.idleBytes = m_idleBytes;
+    stats.budgetBytes = m_budgetBytes;
+    return stats;
+}
+
+void PixelBufferPool::Recycler::operator()(Buffer* buffer) const
+{
+    pool->recycle(buffer);
+}
+
+size_t PixelBufferPool::classCapacity(size_t pixelCount)
+{
+    size_t power = MIN_POOLED_PIXELS;
+    while (power < pixelCount)
+    {
+        power <<= 1;
+    }
+    const size_t step = power / CLASSES_PER_DOUBLING;
+    return (pixelCount + step - 1) / step * step;
+}
+
+void PixelBufferPool::recycle(Buffer* buffer)
+{
+    const size_t bytes = bufferBytes(*buffer);
+    if (buffer->capacity() < MIN_POOLED_PIXELS)
+    {
+        delete buffer;
+        return;
+    }
+
+    std::vector<Buffer*> released;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (bytes > m_budgetBytes)
+        {
+            ++m_released;
+            released.push_back(buffer);
+        }
+        else
+        {
+            // Make room by dropping the oldest; the newest is the likeliest
+            // size for the next render
+            trimLocked(m_budgetBytes - bytes, released);
+            m_idle.push_back(buffer);
+            m_idleBytes += bytes;
+        }
+    }
+    for (Buffer* victim : released)
+    {
+        delete victim;
+    }
+}
+
+void PixelBufferPool::trimLocked(size_t keepBytes, std::vector<Buffer*>& released)
+{
+    while (m_idleBytes > keepBytes && !m_idle.empty())
+    {
+        Buffer* victim = m_idle.front();
+        m_idle.pop_front();
+        m_idleBytes -= bufferBytes(*victim);
+        released.push_back(victim);
+        ++m_released;
+    }
+}
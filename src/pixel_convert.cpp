@@ -0,0 +1,357 @@
+#include "pixel_convert.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_CONVERT_HAVE_NEON 1
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define PIXEL_CONVERT_HAVE_X86 1
+#endif
+
+namespace pixel_convert
+{
+namespace scalar
+{
+void rgbaToArgb(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t* px = src + i * 4;
+        dst[i] = (static_cast<uint32_t>(px[3]) << 24) | (static_cast<uint32_t>(px[0]) << 16) |
+                 (static_cast<uint32_t>(px[1]) << 8) | static_cast<uint32_t>(px[2]);
+    }
+}
+
+void rgbToArgb(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t* px = src + i * 3;
+        dst[i] = 0xFF000000u | (static_cast<uint32_t>(px[0]) << 16) | (static_cast<uint32_t>(px[1]) << 8) |
+                 static_cast<uint32_t>(px[2]);
+    }
+}
+
+void argbToRgb(const uint32_t* src, uint8_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t argb = src[i];
+        dst[i * 3] = static_cast<uint8_t>((argb >> 16) & 0xFF);
+        dst[i * 3 + 1] = static_cast<uint8_t>((argb >> 8) & 0xFF);
+        dst[i * 3 + 2] = static_cast<uint8_t>(argb & 0xFF);
+    }
+}
+} // namespace scalar
+} // namespace pixel_convert
+
+namespace
+{
+using pixel_convert::Kernels;
+
+Kernels scalarKernels()
+{
+    Kernels kernels;
+    kernels.rgbaToArgb = pixel_convert::scalar::rgbaToArgb;
+    kernels.rgbToArgb = pixel_convert::scalar::rgbToArgb;
+    kernels.argbToRgb = pixel_convert::scalar::argbToRgb;
+    return kernels;
+}
+
+// The vector kernels treat an ARGB word as B,G,R,A bytes, so they are only
+// built for little-endian targets (every NEON/x86 target we ship).
+
+#ifdef PIXEL_CONVERT_HAVE_NEON
+void rgbaToArgbNeon(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t px = vld4q_u8(src + i * 4); // R, G, B, A planes
+        uint8x16_t red = px.val[0];
+        px.val[0] = px.val[2];
+        px.val[2] = red;
+        vst4q_u8(out + i * 4, px); // B, G, R, A
+    }
+    pixel_convert::scalar::rgbaToArgb(src + i * 4, dst + i, count - i);
+}
+
+void rgbToArgbNeon(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+    const uint8x16_t opaque = vdupq_n_u8(0xFF);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x3_t px = vld3q_u8(src + i * 3);
+        uint8x16x4_t argb;
+        argb.val[0] = px.val[2];
+        argb.val[1] = px.val[1];
+        argb.val[2] = px.val[0];
+        argb.val[3] = opaque;
+        vst4q_u8(out + i * 4, argb);
+    }
+    pixel_convert::scalar::rgbToArgb(src + i * 3, dst + i, count - i);
+}
+
+void argbToRgbNeon(const uint32_t* src, uint8_t* dst, size_t count)
+{
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t px = vld4q_u8(in + i * 4); // B, G, R, A planes
+        uint8x16x3_t rgb;
+        rgb.val[0] = px.val[2];
+        rgb.val[1] = px.val[1];
+        rgb.val[2] = px.val[0];
+        vst3q_u8(dst + i * 3, rgb);
+    }
+    pixel_convert::scalar::argbToRgb(src + i, dst + i * 3, count - i);
+}
+#endif // PIXEL_CONVERT_HAVE_NEON
+
+#ifdef PIXEL_CONVERT_HAVE_X86
+// RGBA read as a little-endian word is 0xAABBGGRR; swap the R and B bytes
+__attribute__((target("sse2"))) void rgbaToArgbSse2(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+    const __m128i low = _mm_set1_epi32(0x000000FF);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m128i ag = _mm_and_si128(px, keep);
+        __m128i r = _mm_slli_epi32(_mm_and_si128(px, low), 16);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(px, 16), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(ag, _mm_or_si128(r, b)));
+    }
+    pixel_convert::scalar::rgbaToArgb(src + i * 4, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) void rgbaToArgbAvx2(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    const __m256i swapRB = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(px, swapRB));
+    }
+    pixel_convert::scalar::rgbaToArgb(src + i * 4, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) void rgbToArgbAvx2(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    // Each 128-bit lane expands 4 packed RGB pixels (12 bytes) to B,G,R,A
+    const __m256i expand = _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    size_t i = 0;
+    // The second 16-byte load ends 28 bytes in, so stop while 10 pixels remain
+    for (; i + 10 <= count; i += 8)
+    {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 12));
+        __m256i px = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        __m256i argb = _mm256_or_si256(_mm256_shuffle_epi8(px, expand), opaque);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), argb);
+    }
+    pixel_convert::scalar::rgbToArgb(src + i * 3, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) void argbToRgbAvx2(const uint32_t* src, uint8_t* dst, size_t count)
+{
+    // Each lane packs 4 B,G,R,A pixels into 12 R,G,B bytes followed by 4 spare bytes
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+    // The upper lane's 16-byte store ends 28 bytes in, so stop while 10 pixels remain
+    for (; i + 10 <= count; i += 8)
+    {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i rgb = _mm256_shuffle_epi8(px, pack);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3), _mm256_castsi256_si128(rgb));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3 + 12), _mm256_extracti128_si256(rgb, 1));
+    }
+    pixel_convert::scalar::argbToRgb(src + i, dst + i * 3, count - i);
+}
+#endif // PIXEL_CONVERT_HAVE_X86
+
+// Run each selected kernel over an odd-sized buffer (so tails are exercised)
+// and compare with the scalar reference.
+bool kernelsMatchScalar(const Kernels& kernels)
+{
+    constexpr size_t COUNT = 67;
+    std::vector<uint8_t> rgba(COUNT * 4);
+    std::vector<uint8_t> rgb(COUNT * 3);
+    for (size_t i = 0; i < rgba.size(); ++i)
+    {
+        rgba[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+    for (size_t i = 0; i < rgb.size(); ++i)
+    {
+        rgb[i] = static_cast<uint8_t>(i * 53 + 7);
+    }
+
+    std::vector<uint32_t> expectedArgb(COUNT);
+    std::vector<uint32_t> actualArgb(COUNT);
+    pixel_convert::scalar::rgbaToArgb(rgba.data(), expectedArgb.data(), COUNT);
+    kernels.rgbaToArgb(rgba.data(), actualArgb.data(), COUNT);
+    if (expectedArgb != actualArgb)
+    {
+        return false;
+    }
+
+    pixel_convert::scalar::rgbToArgb(rgb.data(), expectedArgb.data(), COUNT);
+    kernels.rgbToArgb(rgb.data(), actualArgb.data(), COUNT);
+    if (expectedArgb != actualArgb)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> expectedRgb(COUNT * 3);
+    std::vector<uint8_t> actualRgb(COUNT * 3);
+    pixel_convert::scalar::argbToRgb(expectedArgb.data(), expectedRgb.data(), COUNT);
+    kernels.argbToRgb(expectedArgb.data(), actualRgb.data(), COUNT);
+    return expectedRgb == actualRgb;
+}
+
+Kernels selectKernels()
+{
+    // Most capable first
+    Kernels kernels = scalarKernels();
+    for (pixel_convert::Isa isa : {pixel_convert::Isa::Neon, pixel_convert::Isa::Avx2, pixel_convert::Isa::Sse2})
+    {
+        if (pixel_convert::kernelsFor(isa, kernels))
+        {
+            break;
+        }
+    }
+
+    if (kernels.isa != pixel_convert::Isa::Scalar && !kernelsMatchScalar(kernels))
+    {
+        std::cerr << "pixel_convert: " << pixel_convert::isaName(kernels.isa)
+                  << " kernels disagree with the scalar reference, using scalar" << std::endl;
+        kernels = scalarKernels();
+    }
+
+    std::cout << "pixel_convert: using " << pixel_convert::isaName(kernels.isa) << " kernels" << std::endl;
+    return kernels;
+}
+
+const Kernels& kernels()
+{
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+} // namespace
+
+namespace pixel_convert
+{
+Isa activeIsa()
+{
+    return kernels().isa;
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Sse2:
+        return "SSE2";
+    case Isa::Avx2:
+        return "AVX2";
+    case Isa::Neon:
+        return "NEON";
+    case Isa::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+bool kernelsFor(Isa isa, Kernels& kernels)
+{
+    kernels = scalarKernels();
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return true;
+#if defined(PIXEL_CONVERT_HAVE_NEON)
+    case Isa::Neon:
+        kernels.isa = Isa::Neon;
+        kernels.rgbaToArgb = rgbaToArgbNeon;
+        kernels.rgbToArgb = rgbToArgbNeon;
+        kernels.argbToRgb = argbToRgbNeon;
+        return true;
+#elif defined(PIXEL_CONVERT_HAVE_X86)
+    case Isa::Avx2:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2"))
+        {
+            return false;
+        }
+        kernels.isa = Isa::Avx2;
+        kernels.rgbaToArgb = rgbaToArgbAvx2;
+        kernels.rgbToArgb = rgbToArgbAvx2;
+        kernels.argbToRgb = argbToRgbAvx2;
+        return true;
+    case Isa::Sse2:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("sse2"))
+        {
+            return false;
+        }
+        // SSE2 has no byte shuffle, so only the RGBA swizzle is vectorized
+        kernels.isa = Isa::Sse2;
+        kernels.rgbaToArgb = rgbaToArgbSse2;
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+void rgbaToArgb(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    kernels().rgbaToArgb(src, dst, count);
+}
+
+void rgbToArgb(const uint8_t* src, uint32_t* dst, size_t count)
+{
+    kernels().rgbToArgb(src, dst, count);
+}
+
+void argbToRgb(const uint32_t* src, uint8_t* dst, size_t count)
+{
+    kernels().argbToRgb(src, dst, count);
+}
+
+void copyRows32(const uint8_t* src, int srcPitch, uint32_t* dst, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * sizeof(uint32_t);
+    if (static_cast<size_t>(srcPitch) == rowBytes)
+    {
+        std::memcpy(dst, src, rowBytes * static_cast<size_t>(height));
+        return;
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        std::memcpy(dst + static_cast<size_t>(y) * width, src + static_cast<size_t>(y) * srcPitch, rowBytes);
+    }
+}
+} // namespace pixel_convert
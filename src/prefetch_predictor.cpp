@@ -0,0 +1,158 @@
+#include "prefetch_predictor.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr size_t HISTORY_STEPS = 8;
+constexpr uint32_t STEADY_GAP_MS = 4000; // Longer pauses are reading, not skimming
+constexpr uint32_t FAST_FLIP_MS = 800;   // Turns closer than this count as skimming
+constexpr int BASE_DEPTH = 2;
+#ifdef TRIMUI_PLATFORM
+constexpr int MAX_DEPTH = 4;
+#else
+constexpr int MAX_DEPTH = 6;
+#endif
+constexpr uint32_t PREFETCH_WORK_BUDGET_MS = 1200; // Render time worth queueing ahead of the reader
+} // namespace
+
+void PrefetchPredictor::recordPageChange(int fromPage, int toPage, uint32_t timestampMs)
+{
+    if (toPage == fromPage)
+    {
+        return;
+    }
+
+    ++m_stats.pageChanges;
+    if (!m_lastPlan.empty())
+    {
+        if (m_lastPlan.count(toPage))
+        {
+            ++m_stats.hits;
+        }
+        else
+        {
+            ++m_stats.misses;
+        }
+        // A plan only predicts the next turn
+        m_lastPlan.clear();
+    }
+
+    m_history.push_back(Step{toPage - fromPage, timestampMs});
+    if (m_history.size() > HISTORY_STEPS)
+    {
+        m_history.pop_front();
+    }
+}
+
+std::vector<int> PrefetchPredictor::plan(int currentPage, int pageCount, uint32_t renderMs, size_t pageBytes,
+                                         size_t cacheBudgetBytes)
+{
+    const uint32_t interval = typicalIntervalMs();
+    const bool skimming = interval > 0 && interval < FAST_FLIP_MS;
+
+    // The faster the turns, the further ahead the reader will be by the time
+    // the queue drains
+    int depth = BASE_DEPTH;
+    if (skimming)
+    {
+        depth = BASE_DEPTH + static_cast<int>((FAST_FLIP_MS + interval - 1) / interval) - 1;
+    }
+
+    // Slow pages: only queue as much work as is likely to finish in time
+    if (renderMs > 0)
+    {
+        depth = std::min(depth, std::max(1, static_cast<int>(PREFETCH_WORK_BUDGET_MS / renderMs)));
+    }
+
+    // Leave room in the page cache for the current page and the one behind it
+    if (pageBytes > 0 && cacheBudgetBytes > 0)
+    {
+        const size_t fits = cacheBudgetBytes / pageBytes;
+        depth = std::min(depth, fits > 2 ? static_cast<int>(std::min<size_t>(fits - 2, MAX_DEPTH)) : 1);
+    }
+    depth = std::max(1, std::min(depth, MAX_DEPTH));
+
+    const int step = direction();
+    std::vector<int> pages;
+    for (int i = 1; i <= depth; ++i)
+    {
+        const int page = currentPage + step * i;
+        if (page >= 0 && page < pageCount)
+        {
+            pages.push_back(page);
+        }
+    }
+
+    // A steady reader sometimes turns back to re-read; a skimmer does not
+    const int behind = currentPage - step;
+    if (!skimming && behind >= 0 && behind < pageCount)
+    {
+        pages.push_back(behind);
+    }
+
+    m_stats.direction = step;
+    m_stats.depth = depth;
+    return pages;
+}
+
+void PrefetchPredictor::recordIssuedPlan(const std::vector<int>& pages)
+{
+    m_lastPlan = std::set<int>(pages.begin(), pages.end());
+}
+
+bool PrefetchPredictor::isSkimming(uint32_t nowMs) const
+{
+    if (m_history.empty() || nowMs - m_history.back().timestampMs >= FAST_FLIP_MS)
+    {
+        return false;
+    }
+    const uint32_t interval = typicalIntervalMs();
+    return interval > 0 && interval < FAST_FLIP_MS;
+}
+
+void PrefetchPredictor::reset()
+{
+    m_history.clear();
+    m_lastPlan.clear();
+    m_stats = Stats();
+}
+
+PrefetchPredictor::Stats PrefetchPredictor::getStats() const
+{
+    return m_stats;
+}
+
+int PrefetchPredictor::direction() const
+{
+    // Newest step weighs most; each older one counts half as much
+    float score = 0.0f;
+    float weight = 1.0f;
+    for (auto it = m_history.rbegin(); it != m_history.rend(); ++it)
+    {
+        score += (it->delta > 0 ? weight : -weight);
+        weight *= 0.5f;
+    }
+    return score < 0.0f ? -1 : 1;
+}
+
+uint32_t PrefetchPredictor::typicalIntervalMs() const
+{
+    std::vector<uint32_t> gaps;
+    for (size_t i = 1; i < m_history.size(); ++i)
+    {
+        const uint32_t gap = m_history[i].timestampMs - m_history[i - 1].timestampMs;
+        if (gap <= STEADY_GAP_MS)
+        {
+            gaps.push_back(gap);
+        }
+    }
+    if (gaps.size() < 2)
+    {
+        return 0;
+    }
+
+    // Median, so one long pause or double tap does not skew the pace
+    std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+    return std::max<uint32_t>(1, gaps[gaps.size() / 2]);
+}
@@ -4,6 +4,8 @@
 #include "mupdf_document.h"
 #include "text_document.h"
 #include "navigation_manager.h"
+#include "pixel_buffer_pool.h"
+#include "pixel_convert.h"
 #include "renderer.h"
 #include "text_renderer.h"
 #include "viewport_manager.h"
@@ -11,6 +13,21 @@
 #include <cmath>
 #include <iostream>
 
+namespace
+{
+// Cold page turns of pages at least this large show a quick low-resolution
+// pass first; smaller pages render fast enough in one go
+#ifdef TRIMUI_PLATFORM
+constexpr int PROGRESSIVE_MIN_PIXELS = 480 * 360;
+#else
+constexpr int PROGRESSIVE_MIN_PIXELS = 960 * 720;
+#endif
+constexpr int PROGRESSIVE_SCALE_DIVISOR = 4; // First pass at a quarter of the scale
+constexpr int PROGRESSIVE_MIN_SCALE = 10;
+
+constexpr Uint32 RENDER_PROGRESS_DELAY_MS = 300; // Renders faster than this never show a bar
+} // namespace
+
 RenderManager::RenderManager(SDL_Window* window, SDL_Renderer* renderer)
 {
     // Prefer nearest sampling to avoid softness when rotating at 90°/270°
@@ -38,6 +55,7 @@ void RenderManager::clearLastRender(Document* document)
     // Clear the cached preview render
     m_lastArgbValid = false;
     m_lastArgbBuffer.reset();
+    m_lastTextureUploadId = 0;
     m_lastArgbPage = -1;
     m_lastArgbScale = -1;
 
@@ -65,8 +83,13 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
     int srcW = 0;
     int srcH = 0;
     std::shared_ptr<const std::vector<uint32_t>> argbData;
+    uint64_t textureUploadId = 0; // Set when the page is already in the page texture
     bool usedPreview = false;
     bool highResReady = false;
+    bool interactive = false; // Zooming or flipping quickly: favour speed over quality
+    bool draftRender = false;
+    int progressiveScale = 0; // Scale of the quick first pass, if one was drawn
+    bool awaitingFirstPass = false; // Cold large page: nothing to draw until the queued passes land
     MuPdfDocument* muPdfDocPtr = dynamic_cast<MuPdfDocument*>(document);
     TextDocument* textDocPtr = dynamic_cast<TextDocument*>(document);
     int currentPage = navigationManager->getCurrentPage();
@@ -74,11 +97,39 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
 
     m_previewActive = false;
 
+    // A cold turn left before its full render landed is not measured
+    if (m_pendingFullPage != currentPage || m_pendingFullScale != currentScale)
+    {
+        m_pendingFullPage = -1;
+    }
+
     if (muPdfDocPtr)
     {
         // Pass background color to MuPDF for proper rendering
         muPdfDocPtr->setBackgroundColor(m_bgColorR, m_bgColorG, m_bgColorB);
 
+        // Pages that will be replaced within a few frames are drawn at draft quality
+        interactive = viewportManager->isZoomDebouncing() ||
+                      navigationManager->getPrefetchPredictor().isSkimming(SDL_GetTicks());
+        muPdfDocPtr->setDraftRendering(interactive);
+
+        // High zoom levels are drawn from tiles. While a zoom burst is still settling,
+        // a stretched preview of the same page is cheaper than rasterizing tiles that
+        // will be thrown away on the next step.
+        bool previewAvailable = m_lastArgbValid && m_lastArgbPage == currentPage && m_lastArgbBuffer;
+        if (muPdfDocPtr->shouldUseTiledRendering(currentScale) &&
+            !(previewAvailable && viewportManager->isZoomDebouncing()) &&
+            renderTiledPage(muPdfDocPtr, currentPage, currentScale, viewportManager, winW, winH))
+        {
+            if (!viewportManager->isZoomDebouncing() && !isDragging)
+            {
+                requestZoomIntentRender(muPdfDocPtr, currentPage, viewportManager, winW, winH);
+            }
+            m_state.lastRenderDuration = SDL_GetTicks() - renderStart;
+            navigationManager->setLastRenderDuration(m_state.lastRenderDuration);
+            return;
+        }
+
         try
         {
             MuPdfDocument::ArgbBufferPtr cachedBuffer;
@@ -96,22 +147,89 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
                 srcH = m_lastArgbHeight;
                 usedPreview = true;
             }
-            else
+            else if (m_lastArgbValid && m_lastArgbPage == currentPage &&
+                     m_renderer->holdsPageUpload(m_lastTextureUploadId))
             {
-                // No preview available (wrong page or first render), must render synchronously
-                // This is the slow path but necessary for page changes
-                argbData = muPdfDocPtr->renderPageARGB(currentPage, srcW, srcH, currentScale);
+                // The last render of this page went straight to the texture: redraw it as is,
+                // or stretch it as the preview when the scale has changed since
+                textureUploadId = m_lastTextureUploadId;
+                srcW = m_lastArgbWidth;
+                srcH = m_lastArgbHeight;
+                usedPreview = m_lastArgbScale != currentScale || m_lastRenderDraft;
+            }
+            else if (muPdfDocPtr->tryLoadPageFromDiskCache(currentPage, currentScale, cachedBuffer, srcW, srcH))
+            {
+                // Rendered in an earlier session; decompressing is far cheaper than rasterizing.
+                // Checked after the two branches above: a page rendered straight into the
+                // texture is on disk but not in memory, and redrawing it must not reload it.
+                argbData = cachedBuffer;
                 highResReady = static_cast<bool>(argbData);
             }
+            else
+            {
+                // No preview available (wrong page or first render). Small pages are
+                // rendered synchronously; this is the slow path but necessary for page changes.
+                if (m_pendingFullPage != currentPage)
+                {
+                    m_pendingFullPage = currentPage;
+                    m_pendingFullScale = currentScale;
+                    m_pendingFullStart = renderStart;
+                    m_pendingFirstVisual = true;
+                }
+
+                // Large pages are never interpreted on this thread: a low-resolution first
+                // pass and the full render are queued, and the frames in between show the
+                // background until the first pass lands. The full render then replaces it
+                // like any other preview.
+                const int pagePixels = viewportManager->getPageWidth() * viewportManager->getPageHeight();
+                const int previewScale = std::max(PROGRESSIVE_MIN_SCALE, currentScale / PROGRESSIVE_SCALE_DIVISOR);
+                if (pagePixels >= PROGRESSIVE_MIN_PIXELS && previewScale < currentScale)
+                {
+                    MuPdfDocument::ArgbBufferPtr firstPass;
+                    if (muPdfDocPtr->tryGetCachedPageARGB(currentPage, previewScale, firstPass, srcW, srcH))
+                    {
+                        argbData = firstPass;
+                        progressiveScale = previewScale;
+                        usedPreview = true;
+                    }
+                    else
+                    {
+                        muPdfDocPtr->requestPagePreviewAsync(currentPage, previewScale);
+                        muPdfDocPtr->requestPageRenderAsync(currentPage, currentScale);
+                        awaitingFirstPass = true;
+                    }
+                }
+
+                if (!argbData && !awaitingFirstPass)
+                {
+                    // A page that fits the window needs no CPU-side copy (no minimap, no panning),
+                    // so it is rasterized straight into the page texture without a staging buffer.
+                    if (viewportManager->getPageWidth() <= winW && viewportManager->getPageHeight() <= winH)
+                    {
+                        textureUploadId = renderPageIntoTexture(muPdfDocPtr, currentPage, currentScale, srcW, srcH);
+                    }
+                    if (textureUploadId == 0)
+                    {
+                        argbData = muPdfDocPtr->renderPageARGB(currentPage, srcW, srcH, currentScale);
+                    }
+                    highResReady = textureUploadId != 0 || static_cast<bool>(argbData);
+                    // A draft stays up as the preview until the full-quality render lands
+                    draftRender = interactive;
+                    usedPreview = interactive;
+                }
+
+                if ((argbData || textureUploadId != 0) && m_pendingFirstVisual)
+                {
+                    recordFirstVisual(SDL_GetTicks() - m_pendingFullStart, progressiveScale != 0);
+                    m_pendingFirstVisual = false;
+                }
+            }
         }
         catch (const std::exception&)
         {
             std::vector<uint8_t> rgbData = document->renderPage(currentPage, srcW, srcH, currentScale);
-            auto converted = std::make_shared<std::vector<uint32_t>>(static_cast<size_t>(srcW) * static_cast<size_t>(srcH));
-            for (int i = 0; i < srcW * srcH; ++i)
-            {
-                (*converted)[static_cast<size_t>(i)] = rgb24_to_argb32(rgbData[i * 3], rgbData[i * 3 + 1], rgbData[i * 3 + 2]);
-            }
+            auto converted = PixelBufferPool::shared().acquire(static_cast<size_t>(srcW) * static_cast<size_t>(srcH));
+            pixel_convert::rgbToArgb(rgbData.data(), converted->data(), converted->size());
             argbData = converted;
             highResReady = true;
         }
@@ -136,11 +254,8 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
         catch (const std::exception&)
         {
             std::vector<uint8_t> rgbData = document->renderPage(currentPage, srcW, srcH, currentScale);
-            auto converted = std::make_shared<std::vector<uint32_t>>(static_cast<size_t>(srcW) * static_cast<size_t>(srcH));
-            for (int i = 0; i < srcW * srcH; ++i)
-            {
-                (*converted)[static_cast<size_t>(i)] = rgb24_to_argb32(rgbData[i * 3], rgbData[i * 3 + 1], rgbData[i * 3 + 2]);
-            }
+            auto converted = PixelBufferPool::shared().acquire(static_cast<size_t>(srcW) * static_cast<size_t>(srcH));
+            pixel_convert::rgbToArgb(rgbData.data(), converted->data(), converted->size());
             argbData = converted;
             highResReady = true;
         }
@@ -148,32 +263,61 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
     else
     {
         std::vector<uint8_t> rgbData = document->renderPage(currentPage, srcW, srcH, currentScale);
-        auto converted = std::make_shared<std::vector<uint32_t>>(static_cast<size_t>(srcW) * static_cast<size_t>(srcH));
-        for (int i = 0; i < srcW * srcH; ++i)
-        {
-            (*converted)[static_cast<size_t>(i)] = rgb24_to_argb32(rgbData[i * 3], rgbData[i * 3 + 1], rgbData[i * 3 + 2]);
-        }
+        auto converted = PixelBufferPool::shared().acquire(static_cast<size_t>(srcW) * static_cast<size_t>(srcH));
+        pixel_convert::rgbToArgb(rgbData.data(), converted->data(), converted->size());
         argbData = converted;
         highResReady = true;
     }
 
-    if (!argbData)
-    {
-        return;
-    }
-
-    if (usedPreview && muPdfDocPtr)
+    // Sampled before the early return below, so a cold page that shows nothing
+    // yet still reports the progress of its queued render
+    m_progressActive = false;
+    if ((usedPreview || awaitingFirstPass) && muPdfDocPtr)
     {
         m_previewActive = true;
-        if (!viewportManager->isZoomDebouncing())
+        if (usedPreview && !interactive)
         {
             muPdfDocPtr->requestPageRenderAsync(currentPage, currentScale);
         }
+        MuPdfDocument::RenderProgress progress = muPdfDocPtr->getRenderProgress(currentPage);
+        m_progressActive = progress.active;
+        m_progressPage = currentPage;
+        m_progressElapsedMs = progress.elapsedMs;
+        // Rasterizing reports its share of the display list; interpreting the page does not
+        m_progressFraction = progress.progressMax > 0
+                                 ? std::min(1.0f, static_cast<float>(progress.progress) / static_cast<float>(progress.progressMax))
+                                 : -1.0f;
+    }
+
+    if (!argbData && textureUploadId == 0)
+    {
+        return;
     }
 
     if (highResReady)
     {
-        storeLastRender(currentPage, currentScale, argbData, srcW, srcH);
+        storeLastRender(currentPage, currentScale, argbData, srcW, srcH, textureUploadId);
+        m_lastRenderDraft = draftRender;
+        m_lastRenderProgressive = false;
+        if (!draftRender && currentPage == m_pendingFullPage && currentScale == m_pendingFullScale)
+        {
+            if (m_pendingFirstVisual)
+            {
+                // The full render beat the first pass to the cache
+                recordFirstVisual(SDL_GetTicks() - m_pendingFullStart, false);
+                m_pendingFirstVisual = false;
+            }
+            m_pageTurnStats.fullQualityTotalMs += SDL_GetTicks() - m_pendingFullStart;
+            ++m_pageTurnStats.fullQualityTurns;
+            m_pendingFullPage = -1;
+        }
+    }
+    else if (progressiveScale != 0)
+    {
+        // Kept as this page's preview until the full render is cached
+        storeLastRender(currentPage, progressiveScale, argbData, srcW, srcH, 0);
+        m_lastRenderDraft = true;
+        m_lastRenderProgressive = true;
     }
 
     // Don't update viewport dimensions based on render buffer size!
@@ -203,8 +347,10 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
         // At 90° or 270°, always render using the source buffer dimensions.
         // Even if the buffer is from a previous zoom step, keep showing it (with rotation)
         // to avoid flashing the unrotated background while the new render arrives.
-        renderWidth = srcW;
-        renderHeight = srcH;
+        // A progressive first pass is the exception: it is stretched to the page.
+        bool lowResPass = usedPreview && m_lastRenderProgressive && m_lastArgbPage == currentPage;
+        renderWidth = lowResPass ? pageRect.h : srcW;
+        renderHeight = lowResPass ? pageRect.w : srcH;
 
         // Keep the rotated content centered at the intended page position.
         float centerX = static_cast<float>(pageRect.x) + static_cast<float>(pageRect.w) * 0.5f;
@@ -225,10 +371,19 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
         }
     }
 
-    m_renderer->renderPageExARGB(*argbData, srcW, srcH,
-                                 renderX, renderY, renderWidth, renderHeight,
-                                 static_cast<double>(rotation),
-                                 viewportManager->currentFlipFlags(), argbData.get());
+    if (argbData)
+    {
+        m_renderer->renderPageExARGB(argbData, srcW, srcH,
+                                     renderX, renderY, renderWidth, renderHeight,
+                                     static_cast<double>(rotation),
+                                     viewportManager->currentFlipFlags());
+    }
+    else
+    {
+        m_renderer->drawPageTexture(textureUploadId, srcW, srcH,
+                                    renderX, renderY, renderWidth, renderHeight,
+                                    static_cast<double>(rotation), viewportManager->currentFlipFlags());
+    }
 
     renderDocumentMinimap(argbData, srcW, srcH, pageRect, viewportManager, winW, winH);
 
@@ -244,9 +399,24 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
         auto* muPdfDoc = dynamic_cast<MuPdfDocument*>(document);
         if (muPdfDoc && !muPdfDoc->isPrerenderingActive())
         {
-            muPdfDoc->prerenderAdjacentPagesAsync(navigationManager->getCurrentPage(), viewportManager->getCurrentScale());
+            // Direction and depth follow the reader's recent page turns
+            const int currentPage = navigationManager->getCurrentPage();
+            const size_t pageBytes = static_cast<size_t>(std::max(srcW, 0)) * static_cast<size_t>(std::max(srcH, 0)) *
+                                     sizeof(uint32_t);
+            PrefetchPredictor& predictor = navigationManager->getPrefetchPredictor();
+            std::vector<int> pages = predictor.plan(currentPage, navigationManager->getPageCount(),
+                                                    navigationManager->getLastRenderDuration(), pageBytes,
+                                                    muPdfDoc->getPageCacheStats().budgetBytes);
+            if (muPdfDoc->prerenderPagesAsync(currentPage, pages, viewportManager->getCurrentScale()))
+            {
+                predictor.recordIssuedPlan(pages);
+            }
             lastPrerenderTrigger = currentTime;
         }
+        if (muPdfDoc)
+        {
+            requestZoomIntentRender(muPdfDoc, navigationManager->getCurrentPage(), viewportManager, winW, winH);
+        }
     }
 
     // Measure total render time for dynamic timeout
@@ -254,6 +424,244 @@ void RenderManager::renderCurrentPage(Document* document, NavigationManager* nav
     navigationManager->setLastRenderDuration(m_state.lastRenderDuration);
 }
 
+bool RenderManager::renderTiledPage(MuPdfDocument* document, int page, int scale, ViewportManager* viewportManager,
+                                    int windowWidth, int windowHeight)
+{
+    auto [fullWidth, fullHeight] = document->getPageDimensionsEffective(page, scale);
+    if (fullWidth <= 0 || fullHeight <= 0)
+    {
+        return false;
+    }
+
+    const int tileSize = MuPdfDocument::TILE_SIZE;
+    const int columns = (fullWidth + tileSize - 1) / tileSize;
+    const int rows = (fullHeight + tileSize - 1) / tileSize;
+
+    int posX = (windowWidth - viewportManager->getPageWidth()) / 2 + viewportManager->getScrollX();
+    int posY = (windowHeight - viewportManager->getPageHeight()) / 2 + viewportManager->getScrollY();
+    SDL_Rect pageRect = {posX, posY, viewportManager->getPageWidth(), viewportManager->getPageHeight()};
+
+    int rotation = ((viewportManager->getRotation() % 360) + 360) % 360;
+    bool quarterTurn = (rotation % 180) != 0;
+    SDL_RendererFlip flip = viewportManager->currentFlipFlags();
+
+    // Viewport page size is post-rotation; tiles live in the unrotated page space
+    float displayWidth = static_cast<float>(quarterTurn ? pageRect.h : pageRect.w);
+    float displayHeight = static_cast<float>(quarterTurn ? pageRect.w : pageRect.h);
+    float unitX = displayWidth / static_cast<float>(fullWidth);
+    float unitY = displayHeight / static_cast<float>(fullHeight);
+    float centerX = static_cast<float>(pageRect.x) + static_cast<float>(pageRect.w) * 0.5f;
+    float centerY = static_cast<float>(pageRect.y) + static_cast<float>(pageRect.h) * 0.5f;
+
+    // Prefetch one ring of tiles around the viewport, plus one more on the side
+    // that panning is revealing.
+    int scrollDeltaX = viewportManager->getScrollX() - m_lastTileScrollX;
+    int scrollDeltaY = viewportManager->getScrollY() - m_lastTileScrollY;
+    m_lastTileScrollX = viewportManager->getScrollX();
+    m_lastTileScrollY = viewportManager->getScrollY();
+
+    float ring = static_cast<float>(tileSize) * std::max(unitX, unitY);
+    float prefetchLeft = -ring - (scrollDeltaX > 0 ? ring : 0.0f);
+    float prefetchRight = static_cast<float>(windowWidth) + ring + (scrollDeltaX < 0 ? ring : 0.0f);
+    float prefetchTop = -ring - (scrollDeltaY > 0 ? ring : 0.0f);
+    float prefetchBottom = static_cast<float>(windowHeight) + ring + (scrollDeltaY < 0 ? ring : 0.0f);
+    float focusX = static_cast<float>(windowWidth) * 0.5f + (scrollDeltaX > 0 ? -ring : (scrollDeltaX < 0 ? ring : 0.0f));
+    float focusY = static_cast<float>(windowHeight) * 0.5f + (scrollDeltaY > 0 ? -ring : (scrollDeltaY < 0 ? ring : 0.0f));
+
+    struct PendingTile
+    {
+        int column;
+        int row;
+        float distance;
+    };
+    std::vector<PendingTile> prefetch;
+
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            int tileWidth = std::min(tileSize, fullWidth - column * tileSize);
+            int tileHeight = std::min(tileSize, fullHeight - row * tileSize);
+            float destWidth = static_cast<float>(tileWidth) * unitX;
+            float destHeight = static_cast<float>(tileHeight) * unitY;
+
+            // Tile center relative to the page center, then flipped and rotated like the whole page would be
+            float localX = (static_cast<float>(column * tileSize) + tileWidth * 0.5f) * unitX - displayWidth * 0.5f;
+            float localY = (static_cast<float>(row * tileSize) + tileHeight * 0.5f) * unitY - displayHeight * 0.5f;
+            if (flip & SDL_FLIP_HORIZONTAL)
+                localX = -localX;
+            if (flip & SDL_FLIP_VERTICAL)
+                localY = -localY;
+
+            float screenX = localX;
+            float screenY = localY;
+            if (rotation == 90)
+            {
+                screenX = -localY;
+                screenY = localX;
+            }
+            else if (rotation == 180)
+            {
+                screenX = -localX;
+                screenY = -localY;
+            }
+            else if (rotation == 270)
+            {
+                screenX = localY;
+                screenY = -localX;
+            }
+            screenX += centerX;
+            screenY += centerY;
+
+            float halfExtentX = (quarterTurn ? destHeight : destWidth) * 0.5f;
+            float halfExtentY = (quarterTurn ? destWidth : destHeight) * 0.5f;
+            float left = screenX - halfExtentX;
+            float right = screenX + halfExtentX;
+            float top = screenY - halfExtentY;
+            float bottom = screenY + halfExtentY;
+
+            bool visible = right > 0.0f && left < static_cast<float>(windowWidth) &&
+                           bottom > 0.0f && top < static_cast<float>(windowHeight);
+            if (!visible)
+            {
+                if (right > prefetchLeft && left < prefetchRight && bottom > prefetchTop && top < prefetchBottom)
+                {
+                    float dx = screenX - focusX;
+                    float dy = screenY - focusY;
+                    prefetch.push_back({column, row, dx * dx + dy * dy});
+                }
+                continue;
+            }
+
+            MuPdfDocument::ArgbBufferPtr tileBuffer;
+            int srcW = 0;
+            int srcH = 0;
+            if (!document->tryGetCachedTileARGB(page, scale, column, row, tileBuffer, srcW, srcH))
+            {
+                try
+                {
+                    tileBuffer = document->renderTileARGB(page, scale, column, row, srcW, srcH);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Tile render failed: " << e.what() << std::endl;
+                    continue;
+                }
+            }
+
+            m_renderer->renderTileARGB(tileBuffer, srcW, srcH,
+                                       screenX - destWidth * 0.5f, screenY - destHeight * 0.5f, destWidth, destHeight,
+                                       static_cast<double>(rotation), flip);
+        }
+    }
+
+    std::sort(prefetch.begin(), prefetch.end(),
+              [](const PendingTile& a, const PendingTile& b)
+              {
+                  return a.distance < b.distance;
+              });
+    for (const auto& tile : prefetch)
+    {
+        document->requestTileRenderAsync(page, scale, tile.column, tile.row);
+    }
+
+    // The minimap needs a whole-page image; reuse the last one of this page if we have it
+    if (m_lastArgbValid && m_lastArgbPage == page && m_lastArgbBuffer)
+    {
+        renderDocumentMinimap(m_lastArgbBuffer, m_lastArgbWidth, m_lastArgbHeight, pageRect, viewportManager,
+                              windowWidth, windowHeight);
+    }
+
+    return true;
+}
+
+void RenderManager::requestZoomIntentRender(MuPdfDocument* document, int page, ViewportManager* viewportManager,
+                                            int windowWidth, int windowHeight)
+{
+    const int nextScale = viewportManager->predictedNextScale();
+    if (nextScale <= 0)
+    {
+        return;
+    }
+
+    if (!document->shouldUseTiledRendering(nextScale))
+    {
+        document->requestSpeculativeRender(page, nextScale);
+        return;
+    }
+
+    // Tiled scales are too big to render whole; only the tiles the next step
+    // will show around the current view are worth the work
+    auto [fullWidth, fullHeight] = document->getPageDimensionsEffective(page, nextScale);
+    const int pageWidth = viewportManager->getPageWidth();
+    const int pageHeight = viewportManager->getPageHeight();
+    if (fullWidth <= 0 || fullHeight <= 0 || pageWidth <= 0 || pageHeight <= 0)
+    {
+        return;
+    }
+
+    int rotation = ((viewportManager->getRotation() % 360) + 360) % 360;
+    bool quarterTurn = (rotation % 180) != 0;
+    SDL_RendererFlip flip = viewportManager->currentFlipFlags();
+
+    // Window center relative to the page center, taken back into the unrotated, unflipped page
+    float screenX = static_cast<float>(-viewportManager->getScrollX());
+    float screenY = static_cast<float>(-viewportManager->getScrollY());
+    float localX = screenX;
+    float localY = screenY;
+    if (rotation == 90)
+    {
+        localX = screenY;
+        localY = -screenX;
+    }
+    else if (rotation == 180)
+    {
+        localX = -screenX;
+        localY = -screenY;
+    }
+    else if (rotation == 270)
+    {
+        localX = -screenY;
+        localY = screenX;
+    }
+    if (flip & SDL_FLIP_HORIZONTAL)
+        localX = -localX;
+    if (flip & SDL_FLIP_VERTICAL)
+        localY = -localY;
+
+    float displayWidth = static_cast<float>(quarterTurn ? pageHeight : pageWidth);
+    float displayHeight = static_cast<float>(quarterTurn ? pageWidth : pageHeight);
+    float focusX = (localX / displayWidth + 0.5f) * static_cast<float>(fullWidth);
+    float focusY = (localY / displayHeight + 0.5f) * static_cast<float>(fullHeight);
+
+    // Zooming keeps the same focal point; the window then covers about as many
+    // rendered pixels as it does now
+    const int currentScale = std::max(1, viewportManager->getCurrentScale());
+    auto [currentWidth, currentHeight] = document->getPageDimensionsEffective(page, currentScale);
+    float unit = currentWidth > 0 ? displayWidth / static_cast<float>(currentWidth) : 1.0f;
+    if (unit <= 0.0f)
+    {
+        unit = 1.0f;
+    }
+    const int tileSize = MuPdfDocument::TILE_SIZE;
+    float halfX = static_cast<float>(quarterTurn ? windowHeight : windowWidth) * 0.5f / unit + tileSize;
+    float halfY = static_cast<float>(quarterTurn ? windowWidth : windowHeight) * 0.5f / unit + tileSize;
+
+    const int columns = (fullWidth + tileSize - 1) / tileSize;
+    const int rows = (fullHeight + tileSize - 1) / tileSize;
+    const int firstColumn = std::max(0, static_cast<int>((focusX - halfX) / tileSize));
+    const int lastColumn = std::min(columns - 1, static_cast<int>((focusX + halfX) / tileSize));
+    const int firstRow = std::max(0, static_cast<int>((focusY - halfY) / tileSize));
+    const int lastRow = std::min(rows - 1, static_cast<int>((focusY + halfY) / tileSize));
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            document->requestSpeculativeRender(page, nextScale, column, row);
+        }
+    }
+}
+
 void RenderManager::renderUI(App* app, NavigationManager* navigationManager, ViewportManager* viewportManager)
 {
     int windowWidth = m_renderer->getWindowWidth();
@@ -263,6 +671,7 @@ void RenderManager::renderUI(App* app, NavigationManager* navigationManager, Vie
     renderPageInfo(navigationManager, viewportManager, windowWidth, windowHeight);
     renderScaleInfo(viewportManager, windowWidth, windowHeight);
     renderZoomProcessingIndicator(viewportManager, windowWidth, windowHeight);
+    renderPageProgressIndicator(windowWidth, windowHeight);
     renderErrorMessage(windowWidth, windowHeight);
     renderPageJumpInput(navigationManager, windowWidth, windowHeight);
 
@@ -522,6 +931,68 @@ void RenderManager::renderZoomProcessingIndicator(ViewportManager* viewportManag
     }
 }
 
+void RenderManager::renderPageProgressIndicator(int windowWidth, int windowHeight)
+{
+    (void) windowHeight;
+
+    if (!m_previewActive || !m_progressActive || m_progressElapsedMs < RENDER_PROGRESS_DELAY_MS)
+    {
+        return;
+    }
+
+    bool determinate = m_progressFraction >= 0.0f;
+    float fraction = determinate ? m_progressFraction : 0.0f;
+
+    std::string label = "Rendering page " + std::to_string(m_progressPage + 1);
+    if (determinate)
+    {
+        label += " " + std::to_string(static_cast<int>(fraction * 100.0f)) + "%";
+    }
+    label += " (" + std::to_string(m_progressElapsedMs / 1000) + "." + std::to_string((m_progressElapsedMs / 100) % 10) + "s)";
+
+    int barWidth = 200;
+    int barHeight = 12;
+    int avgCharWidth = 10;
+    int textWidth = static_cast<int>(label.length()) * avgCharWidth;
+    int textHeight = 20;
+    int boxWidth = std::max(textWidth, barWidth) + 24;
+    int boxX = (windowWidth - boxWidth) / 2;
+    int boxY = 20;
+
+    SDL_Rect bgRect = {boxX, boxY, boxWidth, textHeight + barHeight + 28};
+    SDL_SetRenderDrawColor(m_renderer->getSDLRenderer(), 0, 0, 0, 180);
+    SDL_SetRenderDrawBlendMode(m_renderer->getSDLRenderer(), SDL_BLENDMODE_BLEND);
+    SDL_RenderFillRect(m_renderer->getSDLRenderer(), &bgRect);
+
+    SDL_Color textColor = {255, 255, 255, 255};
+    m_textRenderer->renderText(label, boxX + (boxWidth - textWidth) / 2, boxY + 8, textColor);
+
+    // Without a total, the bar stays empty; the elapsed time still shows the render is alive
+    SDL_Color barBgColor = {50, 50, 50, 200};
+    SDL_Color fillColor = {0, 200, 0, 255};
+    renderProgressBar(boxX + (boxWidth - barWidth) / 2, boxY + textHeight + 14, barWidth, barHeight, fraction,
+                      barBgColor, fillColor);
+}
+
+void RenderManager::renderProgressBar(int x, int y, int width, int height, float progress, SDL_Color bgColor,
+                                      SDL_Color fillColor)
+{
+    SDL_Renderer* sdlRenderer = m_renderer->getSDLRenderer();
+
+    SDL_Rect bgRect = {x, y, width, height};
+    SDL_SetRenderDrawColor(sdlRenderer, bgColor.r, bgColor.g, bgColor.b, bgColor.a);
+    SDL_SetRenderDrawBlendMode(sdlRenderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderFillRect(sdlRenderer, &bgRect);
+
+    int fillWidth = static_cast<int>(static_cast<float>(width) * std::max(0.0f, std::min(progress, 1.0f)));
+    SDL_Rect fillRect = {x, y, fillWidth, height};
+    SDL_SetRenderDrawColor(sdlRenderer, fillColor.r, fillColor.g, fillColor.b, fillColor.a);
+    SDL_RenderFillRect(sdlRenderer, &fillRect);
+
+    SDL_SetRenderDrawColor(sdlRenderer, 255, 255, 255, 255);
+    SDL_RenderDrawRect(sdlRenderer, &bgRect);
+}
+
 void RenderManager::renderDocumentMinimap(std::shared_ptr<const std::vector<uint32_t>> argbData, int srcWidth, int srcHeight,
                                           const SDL_Rect& pageRect, ViewportManager* viewportManager,
                                           int windowWidth, int windowHeight)
@@ -613,10 +1084,10 @@ void RenderManager::renderDocumentMinimap(std::shared_ptr<const std::vector<uint
         renderY = centerY - static_cast<float>(renderHeight) * 0.5f;
     }
 
-    m_renderer->renderPageExARGB(*argbData, srcWidth, srcHeight,
+    m_renderer->renderPageExARGB(argbData, srcWidth, srcHeight,
                                  renderX, renderY, renderWidth, renderHeight,
                                  static_cast<double>(rotation),
-                                 viewportManager->currentFlipFlags(), argbData.get());
+                                 viewportManager->currentFlipFlags());
 
     int pageLeft = pageRect.x;
     int pageTop = pageRect.y;
@@ -957,21 +1428,7 @@ void RenderManager::renderEdgeTurnProgressIndicator(App* app, NavigationManager*
             SDL_Color bgColor = {50, 50, 50, 200};
             SDL_Color fillColor = {0, 200, 0, 255};
 
-            // Draw background
-            SDL_Rect bgRect = {indicatorX, indicatorY, barWidth, barHeight};
-            SDL_SetRenderDrawColor(m_renderer->getSDLRenderer(), bgColor.r, bgColor.g, bgColor.b, bgColor.a);
-            SDL_SetRenderDrawBlendMode(m_renderer->getSDLRenderer(), SDL_BLENDMODE_BLEND);
-            SDL_RenderFillRect(m_renderer->getSDLRenderer(), &bgRect);
-
-            // Draw fill
-            int fillWidth = static_cast<int>(barWidth * visualProgress);
-            SDL_Rect fillRect = {indicatorX, indicatorY, fillWidth, barHeight};
-            SDL_SetRenderDrawColor(m_renderer->getSDLRenderer(), fillColor.r, fillColor.g, fillColor.b, fillColor.a);
-            SDL_RenderFillRect(m_renderer->getSDLRenderer(), &fillRect);
-
-            // Draw border
-            SDL_SetRenderDrawColor(m_renderer->getSDLRenderer(), 255, 255, 255, 255);
-            SDL_RenderDrawRect(m_renderer->getSDLRenderer(), &bgRect);
+            renderProgressBar(indicatorX, indicatorY, barWidth, barHeight, visualProgress, bgColor, fillColor);
         }
     }
 }
@@ -981,17 +1438,52 @@ void RenderManager::present()
     m_renderer->present();
 }
 
-uint32_t RenderManager::rgb24_to_argb32(uint8_t r, uint8_t g, uint8_t b)
+uint64_t RenderManager::renderPageIntoTexture(MuPdfDocument* document, int page, int scale, int& width, int& height)
 {
-    return (0xFF << 24) | (r << 16) | (g << 8) | b;
+    bool locked = false;
+    bool rendered = false;
+    try
+    {
+        rendered = document->renderPageARGBInto(page, scale, width, height,
+                                                [this, &locked](int w, int h, int& pitch) -> uint32_t*
+                                                {
+                                                    uint32_t* pixels = m_renderer->lockPageTexture(w, h, pitch);
+                                                    locked = pixels != nullptr;
+                                                    return pixels;
+                                                });
+    }
+    catch (...)
+    {
+        if (locked)
+        {
+            m_renderer->unlockPageTexture(false);
+        }
+        throw;
+    }
+
+    return locked ? m_renderer->unlockPageTexture(rendered) : 0;
+}
+
+void RenderManager::recordFirstVisual(Uint32 elapsedMs, bool progressive)
+{
+    ++m_pageTurnStats.coldTurns;
+    if (progressive)
+    {
+        ++m_pageTurnStats.progressiveTurns;
+    }
+    m_pageTurnStats.lastFirstVisualMs = elapsedMs;
+    m_pageTurnStats.maxFirstVisualMs = std::max(m_pageTurnStats.maxFirstVisualMs, elapsedMs);
+    m_pageTurnStats.firstVisualTotalMs += elapsedMs;
 }
 
-void RenderManager::storeLastRender(int page, int scale, std::shared_ptr<const std::vector<uint32_t>> buffer, int width, int height)
+void RenderManager::storeLastRender(int page, int scale, std::shared_ptr<const std::vector<uint32_t>> buffer, int width, int height,
+                                    uint64_t textureUploadId)
 {
     m_lastArgbBuffer = std::move(buffer);
+    m_lastTextureUploadId = m_lastArgbBuffer ? 0 : textureUploadId;
     m_lastArgbWidth = width;
     m_lastArgbHeight = height;
     m_lastArgbPage = page;
     m_lastArgbScale = scale;
-    m_lastArgbValid = (m_lastArgbBuffer && !m_lastArgbBuffer->empty());
+    m_lastArgbValid = (m_lastArgbBuffer && !m_lastArgbBuffer->empty()) || m_lastTextureUploadId != 0;
 }
@@ -0,0 +1,259 @@
+#include "render_worker_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace
+{
+#ifdef TRIMUI_PLATFORM
+constexpr int DEFAULT_RENDER_WORKERS = 3; // Four A53 cores, one kept for the UI thread
+#else
+constexpr int DEFAULT_RENDER_WORKERS = 4;
+#endif
+constexpr int MAX_RENDER_WORKERS = 16;
+} // namespace
+
+RenderWorkerPool::RenderWorkerPool(int workerCount)
+    : m_workerCount(std::max(1, std::min(workerCount, MAX_RENDER_WORKERS)))
+{
+}
+
+RenderWorkerPool::~RenderWorkerPool()
+{
+    shutdown();
+}
+
+int RenderWorkerPool::defaultWorkerCount()
+{
+    const unsigned int cores = std::thread::hardware_concurrency();
+    if (cores <= 1)
+    {
+        return 1;
+    }
+    return std::min(DEFAULT_RENDER_WORKERS, static_cast<int>(cores) - 1);
+}
+
+void RenderWorkerPool::setWorkerCount(int count)
+{
+    count = std::max(1, std::min(count, MAX_RENDER_WORKERS));
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (count == m_workerCount)
+    {
+        return;
+    }
+
+    m_workerCount = count;
+    if (!m_workers.empty())
+    {
+        stopWorkers(lock);
+        startWorkersLocked();
+    }
+}
+
+int RenderWorkerPool::getWorkerCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_workerCount;
+}
+
+bool RenderWorkerPool::submit(Priority priority, const JobKey& key, Job job)
+{
+    if (!job)
+    {
+        return false;
+    }
+
+    const size_t level = static_cast<size_t>(priority);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_shutdown)
+    {
+        return false;
+    }
+
+    if (std::find(m_running.begin(), m_running.end(), key) != m_running.end())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < PRIORITY_COUNT; ++i)
+    {
+        auto& queue = m_queues[i];
+        auto it = std::find_if(queue.begin(), queue.end(), [&key](const QueuedJob& queued)
+                               { return queued.key == key; });
+        if (it == queue.end())
+        {
+            continue;
+        }
+        if (i > level)
+        {
+            // Already queued behind less urgent work; move it up
+            m_queues[level].push_back(std::move(*it));
+            queue.erase(it);
+        }
+        return false;
+    }
+
+    m_queues[level].push_back(QueuedJob{key, std::move(job)});
+
+    if (m_workers.empty())
+    {
+        startWorkersLocked();
+    }
+
+    lock.unlock();
+    m_workCv.notify_one();
+    return true;
+}
+
+bool RenderWorkerPool::isPending(const KeyPredicate& predicate) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return isPendingLocked(predicate);
+}
+
+void RenderWorkerPool::cancel(const KeyPredicate& predicate)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& queue : m_queues)
+    {
+        queue.erase(std::remove_if(queue.begin(), queue.end(), [&predicate](const QueuedJob& queued)
+                                   { return predicate(queued.key); }),
+                    queue.end());
+    }
+    m_idleCv.notify_all();
+}
+
+void RenderWorkerPool::cancelAll()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& queue : m_queues)
+    {
+        queue.clear();
+    }
+    m_idleCv.notify_all();
+}
+
+void RenderWorkerPool::wait(const KeyPredicate& predicate)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCv.wait(lock, [this, &predicate]()
+                  { return !isPendingLocked(predicate); });
+}
+
+void RenderWorkerPool::shutdown()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+    for (auto& queue : m_queues)
+    {
+        queue.clear();
+    }
+    stopWorkers(lock);
+    m_idleCv.notify_all();
+}
+
+void RenderWorkerPool::startWorkersLocked()
+{
+    m_stopWorkers = false;
+    m_workers.reserve(static_cast<size_t>(m_workerCount));
+    for (int i = 0; i < m_workerCount; ++i)
+    {
+        m_workers.emplace_back(&RenderWorkerPool::workerLoop, this);
+    }
+}
+
+void RenderWorkerPool::stopWorkers(std::unique_lock<std::mutex>& lock)
+{
+    if (m_workers.empty())
+    {
+        return;
+    }
+
+    m_stopWorkers = true;
+    std::vector<std::thread> workers;
+    workers.swap(m_workers);
+    lock.unlock();
+    m_workCv.notify_all();
+
+    for (auto& worker : workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+
+    lock.lock();
+    m_stopWorkers = false;
+}
+
+void RenderWorkerPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_workCv.wait(lock, [this]()
+                      { return m_stopWorkers || std::any_of(m_queues.begin(), m_queues.end(), [](const std::deque<QueuedJob>& queue)
+                                                            { return !queue.empty(); }); });
+        if (m_stopWorkers)
+        {
+            return;
+        }
+
+        auto queueIt = std::find_if(m_queues.begin(), m_queues.end(), [](const std::deque<QueuedJob>& queue)
+                                    { return !queue.empty(); });
+        QueuedJob queued = std::move(queueIt->front());
+        queueIt->pop_front();
+        m_running.push_back(queued.key);
+        lock.unlock();
+
+        try
+        {
+            queued.job();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "RenderWorkerPool: job failed: " << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "RenderWorkerPool: job failed with unknown exception" << std::endl;
+        }
+
+        // Release captured state before reporting the job as finished
+        queued.job = nullptr;
+
+        lock.lock();
+        auto runningIt = std::find(m_running.begin(), m_running.end(), queued.key);
+        if (runningIt != m_running.end())
+        {
+            m_running.erase(runningIt);
+        }
+        m_idleCv.notify_all();
+    }
+}
+
+bool RenderWorkerPool::isPendingLocked(const KeyPredicate& predicate) const
+{
+    for (const auto& key : m_running)
+    {
+        if (predicate(key))
+        {
+            return true;
+        }
+    }
+    for (const auto& queue : m_queues)
+    {
+        for (const auto& queued : queue)
+        {
+            if (predicate(queued.key))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
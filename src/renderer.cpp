@@ -1,5 +1,5 @@
 #include "renderer.h"
-#include "document.h" // Assuming document.h provides rgb24_to_argb32
+#include "pixel_convert.h"
 #include <algorithm>
 #include <cmath>
 #include <cstring> // For memcpy
@@ -16,6 +16,37 @@ inline int roundUpTextureDimension(int value)
     return ((value + GRANULARITY - 1) / GRANULARITY) * GRANULARITY;
 }
 
+// Page buffers hold ARGB8888 words. XRGB8888 (SDL's RGB888) has the same memory
+// layout with the alpha byte ignored, so either can take the buffers as-is.
+// Prefer whichever the renderer supports natively to avoid a driver-side swizzle.
+Uint32 choosePageTextureFormat(SDL_Renderer* renderer)
+{
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0)
+    {
+        return SDL_PIXELFORMAT_ARGB8888;
+    }
+
+    bool hasRgb888 = false;
+    for (Uint32 i = 0; i < info.num_texture_formats; ++i)
+    {
+        if (info.texture_formats[i] == SDL_PIXELFORMAT_ARGB8888)
+        {
+            return SDL_PIXELFORMAT_ARGB8888;
+        }
+        hasRgb888 = hasRgb888 || info.texture_formats[i] == SDL_PIXELFORMAT_RGB888;
+    }
+
+    if (hasRgb888)
+    {
+        return SDL_PIXELFORMAT_RGB888;
+    }
+
+    std::cout << "Renderer: " << (info.name ? info.name : "renderer")
+              << " has no native ARGB8888/RGB888 textures; SDL will convert page uploads" << std::endl;
+    return SDL_PIXELFORMAT_ARGB8888;
+}
+
 #if !SDL_VERSION_ATLEAST(2, 0, 10)
 inline SDL_Rect makeSDLRectFromFloat(float x, float y, float w, float h)
 {
@@ -66,10 +97,68 @@ Renderer::Renderer(SDL_Window* window, SDL_Renderer* renderer)
     // SDL_Init will now happen outside the Renderer class
     // SDL_SetRenderDrawColor(m_renderer.get(), 255, 255, 255, 255); // Use raw pointer
     SDL_SetRenderDrawColor(m_renderer, 255, 255, 255, 255);
+
+    m_textureFormat = choosePageTextureFormat(m_renderer);
+}
+
+Uint32 Renderer::getTextureFormat() const
+{
+    return m_textureFormat;
 }
 
 // renderer.cpp
 
+bool Renderer::ensurePageTexture(int srcWidth, int srcHeight)
+{
+    if (m_texture && srcWidth <= m_currentTexWidth && srcHeight <= m_currentTexHeight)
+    {
+        return true;
+    }
+
+    if (m_texture)
+        m_texture.reset();
+    int allocWidth = roundUpTextureDimension(std::max(srcWidth, m_currentTexWidth));
+    int allocHeight = roundUpTextureDimension(std::max(srcHeight, m_currentTexHeight));
+    m_texture.reset(SDL_CreateTexture(m_renderer,
+                                      m_textureFormat,
+                                      SDL_TEXTUREACCESS_STREAMING,
+                                      allocWidth, allocHeight));
+    m_lastBuffer.reset();
+    m_lastBufferWidth = 0;
+    m_lastBufferHeight = 0;
+    ++m_pageUploadId; // Whatever the old texture held is gone
+    if (!m_texture)
+    {
+        std::cerr << "Error: Unable to create texture! SDL_Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    // Force nearest-neighbor scaling to avoid blur during rotation/scaling
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+    SDL_SetTextureScaleMode(m_texture.get(), SDL_ScaleModeNearest);
+#else
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+#endif
+    m_currentTexWidth = allocWidth;
+    m_currentTexHeight = allocHeight;
+    return true;
+}
+
+void Renderer::copyPageTexture(int srcWidth, int srcHeight,
+                               float destX, float destY, float destWidth, float destHeight,
+                               double angleDeg, SDL_RendererFlip flip)
+{
+    SDL_Rect srcRect = {0, 0, srcWidth, srcHeight};
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+    SDL_FRect destRect = {destX, destY, destWidth, destHeight};
+    SDL_FPoint center{destRect.w / 2.0f, destRect.h / 2.0f}; // float center prevents 0.5px drift on odd sizes
+    SDL_RenderCopyExF(m_renderer, m_texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
+#else
+    SDL_Rect destRect = makeSDLRectFromFloat(destX, destY, destWidth, destHeight);
+    SDL_Point center = makeSDLPointFromFloat(destRect.w / 2.0f, destRect.h / 2.0f);
+    SDL_RenderCopyEx(m_renderer, m_texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
+#endif
+}
+
 void Renderer::renderPageEx(const std::vector<uint8_t>& pixelData,
                             int srcWidth, int srcHeight,
                             float destX, float destY, float destWidth, float destHeight,
@@ -81,29 +170,9 @@ void Renderer::renderPageEx(const std::vector<uint8_t>& pixelData,
         return;
     }
 
-    if (!m_texture || srcWidth > m_currentTexWidth || srcHeight > m_currentTexHeight)
+    if (!ensurePageTexture(srcWidth, srcHeight))
     {
-        if (m_texture)
-            m_texture.reset();
-        int allocWidth = roundUpTextureDimension(std::max(srcWidth, m_currentTexWidth));
-        int allocHeight = roundUpTextureDimension(std::max(srcHeight, m_currentTexHeight));
-        m_texture.reset(SDL_CreateTexture(m_renderer,
-                                          SDL_PIXELFORMAT_ARGB8888,
-                                          SDL_TEXTUREACCESS_STREAMING,
-                                          allocWidth, allocHeight));
-        if (!m_texture)
-        {
-            std::cerr << "Error: Unable to create texture! SDL_Error: " << SDL_GetError() << std::endl;
-            return;
-        }
-        // Force nearest-neighbor scaling to avoid blur during rotation/scaling
-#if SDL_VERSION_ATLEAST(2, 0, 12)
-        SDL_SetTextureScaleMode(m_texture.get(), SDL_ScaleModeNearest);
-#else
-        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
-#endif
-        m_currentTexWidth = allocWidth;
-        m_currentTexHeight = allocHeight;
+        return;
     }
 
     void* pixels;
@@ -119,71 +188,37 @@ void Renderer::renderPageEx(const std::vector<uint8_t>& pixelData,
         const uint8_t* srcRow = pixelData.data() + (static_cast<size_t>(y) * srcWidth * 3);
         uint32_t* destRow = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels) + (static_cast<size_t>(y) * pitch));
 
-        std::fill(destRow, destRow + (pitch / sizeof(uint32_t)), 0xFFFFFFFF);
-
-        for (int x = 0; x < srcWidth; ++x)
-        {
-            destRow[x] = rgb24_to_argb32(srcRow[x * 3], srcRow[x * 3 + 1], srcRow[x * 3 + 2]);
-        }
+        std::fill(destRow + srcWidth, destRow + (pitch / sizeof(uint32_t)), 0xFFFFFFFF);
+        pixel_convert::rgbToArgb(srcRow, destRow, static_cast<size_t>(srcWidth));
     }
 
     SDL_UnlockTexture(m_texture.get());
+    m_lastBuffer.reset();
+    ++m_pageUploadId;
 
-    SDL_Rect srcRect = {0, 0, srcWidth, srcHeight};
-#if SDL_VERSION_ATLEAST(2, 0, 10)
-    SDL_FRect destRect = {destX, destY, destWidth, destHeight};
-    SDL_FPoint center{destRect.w / 2.0f, destRect.h / 2.0f}; // keep true center (avoids odd-size blur)
-    SDL_RenderCopyExF(m_renderer, m_texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
-#else
-    SDL_Rect destRect = makeSDLRectFromFloat(destX, destY, destWidth, destHeight);
-    SDL_Point center = makeSDLPointFromFloat(destRect.w / 2.0f, destRect.h / 2.0f);
-    SDL_RenderCopyEx(m_renderer, m_texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
-#endif
+    copyPageTexture(srcWidth, srcHeight, destX, destY, destWidth, destHeight, angleDeg, flip);
 }
 
-void Renderer::renderPageExARGB(const std::vector<uint32_t>& argbData,
+void Renderer::renderPageExARGB(const std::shared_ptr<const std::vector<uint32_t>>& argbData,
                                 int srcWidth, int srcHeight,
                                 float destX, float destY, float destWidth, float destHeight,
-                                double angleDeg, SDL_RendererFlip flip, const void* bufferToken)
+                                double angleDeg, SDL_RendererFlip flip)
 {
-    if (argbData.empty() || srcWidth == 0 || srcHeight == 0)
+    if (!argbData || argbData->empty() || srcWidth == 0 || srcHeight == 0)
     {
         std::cerr << "Warning: Attempted to render empty or zero-dimension ARGB data." << std::endl;
         return;
     }
 
-    bool textureResized = false;
-    if (!m_texture || srcWidth > m_currentTexWidth || srcHeight > m_currentTexHeight)
+    if (!ensurePageTexture(srcWidth, srcHeight))
     {
-        if (m_texture)
-            m_texture.reset();
-        int allocWidth = roundUpTextureDimension(std::max(srcWidth, m_currentTexWidth));
-        int allocHeight = roundUpTextureDimension(std::max(srcHeight, m_currentTexHeight));
-        m_texture.reset(SDL_CreateTexture(m_renderer,
-                                          SDL_PIXELFORMAT_ARGB8888,
-                                          SDL_TEXTUREACCESS_STREAMING,
-                                          allocWidth, allocHeight));
-        if (!m_texture)
-        {
-            std::cerr << "Error: Unable to create texture! SDL_Error: " << SDL_GetError() << std::endl;
-            return;
-        }
-        // Force nearest-neighbor scaling to avoid blur during rotation/scaling
-#if SDL_VERSION_ATLEAST(2, 0, 12)
-        SDL_SetTextureScaleMode(m_texture.get(), SDL_ScaleModeNearest);
-#else
-        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
-#endif
-        m_currentTexWidth = allocWidth;
-        m_currentTexHeight = allocHeight;
-        textureResized = true;
-        m_lastBufferToken = nullptr;
-        m_lastBufferWidth = 0;
-        m_lastBufferHeight = 0;
+        return;
     }
 
-    bool needsUpload = textureResized || bufferToken == nullptr || bufferToken != m_lastBufferToken ||
-                       srcWidth != m_lastBufferWidth || srcHeight != m_lastBufferHeight;
+    // An expired m_lastBuffer never matches, even if the pool handed the same
+    // vector out again
+    bool needsUpload = m_lastBuffer.lock() != argbData || srcWidth != m_lastBufferWidth ||
+                       srcHeight != m_lastBufferHeight;
 
     if (needsUpload)
     {
@@ -196,7 +231,7 @@ void Renderer::renderPageExARGB(const std::vector<uint32_t>& argbData,
         }
 
         // Direct copy of ARGB data - much faster than RGB conversion
-        const uint32_t* srcData = argbData.data();
+        const uint32_t* srcData = argbData->data();
         for (int y = 0; y < srcHeight; ++y)
         {
             uint32_t* destRow = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels) + (static_cast<size_t>(y) * pitch));
@@ -206,20 +241,152 @@ void Renderer::renderPageExARGB(const std::vector<uint32_t>& argbData,
 
         SDL_UnlockTexture(m_texture.get());
 
-        m_lastBufferToken = bufferToken;
+        m_lastBuffer = argbData;
         m_lastBufferWidth = srcWidth;
         m_lastBufferHeight = srcHeight;
+        ++m_pageUploadId;
+    }
+
+    copyPageTexture(srcWidth, srcHeight, destX, destY, destWidth, destHeight, angleDeg, flip);
+}
+
+uint32_t* Renderer::lockPageTexture(int srcWidth, int srcHeight, int& pitch)
+{
+    if (srcWidth <= 0 || srcHeight <= 0 || !ensurePageTexture(srcWidth, srcHeight))
+    {
+        return nullptr;
+    }
+
+    void* pixels = nullptr;
+    if (SDL_LockTexture(m_texture.get(), NULL, &pixels, &pitch) != 0)
+    {
+        std::cerr << "Error: Unable to lock texture! SDL_Error: " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // From here on the texture no longer holds the last uploaded buffer
+    m_lastBuffer.reset();
+    m_lastBufferWidth = 0;
+    m_lastBufferHeight = 0;
+    return static_cast<uint32_t*>(pixels);
+}
+
+uint64_t Renderer::unlockPageTexture(bool written)
+{
+    SDL_UnlockTexture(m_texture.get());
+    ++m_pageUploadId;
+    return written ? m_pageUploadId : 0;
+}
+
+bool Renderer::holdsPageUpload(uint64_t uploadId) const
+{
+    return uploadId != 0 && uploadId == m_pageUploadId && m_texture;
+}
+
+bool Renderer::drawPageTexture(uint64_t uploadId, int srcWidth, int srcHeight,
+                               float destX, float destY, float destWidth, float destHeight,
+                               double angleDeg, SDL_RendererFlip flip)
+{
+    if (!holdsPageUpload(uploadId))
+    {
+        return false;
+    }
+
+    copyPageTexture(srcWidth, srcHeight, destX, destY, destWidth, destHeight, angleDeg, flip);
+    return true;
+}
+
+void Renderer::renderTileARGB(const std::shared_ptr<const std::vector<uint32_t>>& argbData,
+                              int srcWidth, int srcHeight,
+                              float destX, float destY, float destWidth, float destHeight,
+                              double angleDeg, SDL_RendererFlip flip)
+{
+    if (!argbData || argbData->empty() || srcWidth <= 0 || srcHeight <= 0)
+    {
+        return;
     }
 
+    TileTexture* slot = nullptr;
+    for (auto& tile : m_tileTextures)
+    {
+        if (tile.texture && tile.source.lock() == argbData)
+        {
+            slot = &tile;
+            break;
+        }
+    }
+
+    if (!slot)
+    {
+        if (m_tileTextures.size() < MAX_TILE_TEXTURES)
+        {
+            m_tileTextures.emplace_back();
+            slot = &m_tileTextures.back();
+        }
+        else
+        {
+            slot = &*std::min_element(m_tileTextures.begin(), m_tileTextures.end(),
+                                      [](const TileTexture& a, const TileTexture& b)
+                                      {
+                                          return a.lastUsed < b.lastUsed;
+                                      });
+        }
+
+        if (!slot->texture || srcWidth > slot->width || srcHeight > slot->height)
+        {
+            int allocWidth = roundUpTextureDimension(std::max(srcWidth, slot->width));
+            int allocHeight = roundUpTextureDimension(std::max(srcHeight, slot->height));
+            slot->texture.reset(SDL_CreateTexture(m_renderer,
+                                                  m_textureFormat,
+                                                  SDL_TEXTUREACCESS_STREAMING,
+                                                  allocWidth, allocHeight));
+            slot->source.reset();
+            if (!slot->texture)
+            {
+                slot->width = 0;
+                slot->height = 0;
+                std::cerr << "Error: Unable to create tile texture! SDL_Error: " << SDL_GetError() << std::endl;
+                return;
+            }
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+            SDL_SetTextureScaleMode(slot->texture.get(), SDL_ScaleModeNearest);
+#endif
+            slot->width = allocWidth;
+            slot->height = allocHeight;
+        }
+
+        SDL_Rect lockRect = {0, 0, srcWidth, srcHeight};
+        void* pixels = nullptr;
+        int pitch = 0;
+        if (SDL_LockTexture(slot->texture.get(), &lockRect, &pixels, &pitch) != 0)
+        {
+            slot->source.reset();
+            std::cerr << "Error: Unable to lock tile texture! SDL_Error: " << SDL_GetError() << std::endl;
+            return;
+        }
+
+        const uint32_t* srcData = argbData->data();
+        for (int y = 0; y < srcHeight; ++y)
+        {
+            uint32_t* destRow = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels) + (static_cast<size_t>(y) * pitch));
+            memcpy(destRow, srcData + (static_cast<size_t>(y) * srcWidth), srcWidth * sizeof(uint32_t));
+        }
+
+        SDL_UnlockTexture(slot->texture.get());
+        slot->source = argbData;
+    }
+
+    slot->lastUsed = ++m_tileUseCounter;
+
     SDL_Rect srcRect = {0, 0, srcWidth, srcHeight};
 #if SDL_VERSION_ATLEAST(2, 0, 10)
     SDL_FRect destRect = {destX, destY, destWidth, destHeight};
-    SDL_FPoint center{destRect.w / 2.0f, destRect.h / 2.0f}; // float center prevents 0.5px drift on odd sizes
-    SDL_RenderCopyExF(m_renderer, m_texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
+    SDL_FPoint center{destRect.w / 2.0f, destRect.h / 2.0f};
+    SDL_RenderCopyExF(m_renderer, slot->texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
 #else
     SDL_Rect destRect = makeSDLRectFromFloat(destX, destY, destWidth, destHeight);
     SDL_Point center = makeSDLPointFromFloat(destRect.w / 2.0f, destRect.h / 2.0f);
-    SDL_RenderCopyEx(m_renderer, m_texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
+    SDL_RenderCopyEx(m_renderer, slot->texture.get(), &srcRect, &destRect, angleDeg, &center, flip);
 #endif
 }
 
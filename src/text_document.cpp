@@ -1,4 +1,6 @@
 #include "text_document.h"
+#include "pixel_buffer_pool.h"
+#include "pixel_convert.h"
 
 #include <algorithm>
 #include <chrono>
@@ -561,30 +563,13 @@ TextDocument::ArgbBufferPtr TextDocument::renderPageARGB(int pageNumber, int& wi
         SDL_FreeSurface(lineSurf);
     }
 
-    std::vector<uint32_t> argb(static_cast<size_t>(width) * static_cast<size_t>(height));
-    uint8_t* pixels = static_cast<uint8_t*>(surface->pixels);
-    int pitch = surface->pitch;
-    SDL_PixelFormat* fmt = surface->format;
-
-    for (int row = 0; row < height; ++row)
-    {
-        uint8_t* src = pixels + static_cast<size_t>(row) * pitch;
-        for (int col = 0; col < width; ++col)
-        {
-            uint32_t pixel = 0;
-            memcpy(&pixel, src + col * 4, sizeof(uint32_t));
-            uint8_t r, g, b, a;
-            SDL_GetRGBA(pixel, fmt, &r, &g, &b, &a);
-            argb[static_cast<size_t>(row) * width + col] = (static_cast<uint32_t>(a) << 24) |
-                                                           (static_cast<uint32_t>(r) << 16) |
-                                                           (static_cast<uint32_t>(g) << 8) |
-                                                           static_cast<uint32_t>(b);
-        }
-    }
+    // The surface is ARGB8888 already, so its rows are copied as-is
+    auto bufferPtr = PixelBufferPool::shared().acquire(static_cast<size_t>(width) * static_cast<size_t>(height));
+    pixel_convert::copyRows32(static_cast<const uint8_t*>(surface->pixels), surface->pitch, bufferPtr->data(), width,
+                              height);
 
     SDL_FreeSurface(surface);
 
-    auto bufferPtr = std::make_shared<std::vector<uint32_t>>(std::move(argb));
     {
         std::lock_guard<std::mutex> lock(m_cacheMutex);
         if (m_argbCache.size() >= 5)
@@ -603,13 +588,8 @@ std::vector<uint8_t> TextDocument::renderPage(int pageNum, int& outWidth, int& o
     std::vector<uint8_t> rgb(static_cast<size_t>(outWidth) * static_cast<size_t>(outHeight) * 3);
     if (argb)
     {
-        for (int i = 0; i < outWidth * outHeight; ++i)
-        {
-            uint32_t px = (*argb)[static_cast<size_t>(i)];
-            rgb[static_cast<size_t>(i) * 3] = static_cast<uint8_t>((px >> 16) & 0xFF);
-            rgb[static_cast<size_t>(i) * 3 + 1] = static_cast<uint8_t>((px >> 8) & 0xFF);
-            rgb[static_cast<size_t>(i) * 3 + 2] = static_cast<uint8_t>(px & 0xFF);
-        }
+        pixel_convert::argbToRgb(argb->data(), rgb.data(),
+                                 static_cast<size_t>(outWidth) * static_cast<size_t>(outHeight));
     }
     return rgb;
 }
@@ -71,6 +71,17 @@ void ViewportManager::applyPendingZoom(Document* document, int currentPage)
 
     if (newScale != oldScale)
     {
+        // Track zoom intent for speculative rendering of the next step
+        auto now = std::chrono::steady_clock::now();
+        int step = newScale - oldScale;
+        int direction = step > 0 ? 1 : -1;
+        bool continuing = m_zoomStreak != 0 && (m_zoomStreak > 0) == (direction > 0) &&
+                          std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastZoomAppliedTime).count() <
+                              ZOOM_INTENT_WINDOW_MS;
+        m_zoomStreak = continuing ? m_zoomStreak + direction : direction;
+        m_lastZoomStep = step;
+        m_lastZoomAppliedTime = now;
+
         // Ensure current scroll values reflect the existing page bounds
         clampScroll();
 
@@ -147,6 +158,25 @@ void ViewportManager::applyPendingZoom(Document* document, int currentPage)
     m_zoomProcessing = false;
 }
 
+int ViewportManager::predictedNextScale() const
+{
+    if (std::abs(m_zoomStreak) < 2 || m_lastZoomStep == 0)
+    {
+        return 0;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - m_lastZoomAppliedTime)
+                       .count();
+    if (elapsed >= ZOOM_INTENT_WINDOW_MS)
+    {
+        return 0;
+    }
+
+    int nextScale = std::clamp(m_state.currentScale + m_lastZoomStep, 10, 350);
+    return nextScale != m_state.currentScale ? nextScale : 0;
+}
+
 bool ViewportManager::isZoomDebouncing() const
 {
     if (m_pendingZoomDelta == 0)
@@ -0,0 +1,256 @@
+// Banded rasterization benchmark.
+//
+// Rasterizes one display list on a single context, then split into 2, 4, ...
+// horizontal bands on cloned contexts run by a RenderWorkerPool, the way
+// MuPdfDocument draws large pages. Prints the median time per band count and
+// checks that every banded result is identical to the single-band one.
+//
+// Usage: bench_banded_raster [document [page [width]]]
+// Without a document a vector-heavy page (thousands of stroked and filled
+// curves) is generated, which is where banding pays off the most.
+
+#include "mupdf_locking.h"
+#include "render_worker_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mupdf/fitz.h>
+
+namespace
+{
+constexpr int ITERATIONS = 7;
+constexpr int SYNTHETIC_PATHS = 20000;
+constexpr float PAGE_WIDTH = 595.0f; // A4 in points
+constexpr float PAGE_HEIGHT = 842.0f;
+
+fz_display_list* syntheticPage(fz_context* ctx)
+{
+    fz_display_list* list = fz_new_display_list(ctx, fz_make_rect(0, 0, PAGE_WIDTH, PAGE_HEIGHT));
+    fz_device* dev = fz_new_list_device(ctx, list);
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> x(0.0f, PAGE_WIDTH);
+    std::uniform_real_distribution<float> y(0.0f, PAGE_HEIGHT);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    fz_stroke_state* stroke = fz_new_stroke_state(ctx);
+    stroke->linewidth = 0.6f;
+    for (int i = 0; i < SYNTHETIC_PATHS; ++i)
+    {
+        fz_path* path = fz_new_path(ctx);
+        fz_moveto(ctx, path, x(random), y(random));
+        for (int segment = 0; segment < 4; ++segment)
+        {
+            fz_curveto(ctx, path, x(random), y(random), x(random), y(random), x(random), y(random));
+        }
+        const float color[3] = {unit(random), unit(random), unit(random)};
+        if (i % 3 == 0)
+        {
+            fz_closepath(ctx, path);
+            fz_fill_path(ctx, dev, path, 1, fz_identity, fz_device_rgb(ctx), color, 0.5f, fz_default_color_params);
+        }
+        else
+        {
+            fz_stroke_path(ctx, dev, path, stroke, fz_identity, fz_device_rgb(ctx), color, 1.0f,
+                           fz_default_color_params);
+        }
+        fz_drop_path(ctx, path);
+    }
+    fz_drop_stroke_state(ctx, stroke);
+    fz_close_device(ctx, dev);
+    fz_drop_device(ctx, dev);
+    return list;
+}
+
+bool drawBand(fz_context* ctx, fz_display_list* list, const fz_matrix& transform, const fz_irect& band,
+              unsigned char* rows)
+{
+    fz_pixmap* pix = nullptr;
+    fz_device* dev = nullptr;
+    fz_var(pix);
+    fz_var(dev);
+    bool ok = true;
+    fz_try(ctx)
+    {
+        pix = fz_new_pixmap_with_bbox_and_data(ctx, fz_device_rgb(ctx), band, nullptr, 1, rows);
+        fz_clear_pixmap_with_value(ctx, pix, 255);
+        dev = fz_new_draw_device(ctx, fz_identity, pix);
+        fz_run_display_list(ctx, list, dev, transform, fz_rect_from_irect(band), nullptr);
+        fz_close_device(ctx, dev);
+    }
+    fz_always(ctx)
+    {
+        fz_drop_device(ctx, dev);
+        fz_drop_pixmap(ctx, pix);
+    }
+    fz_catch(ctx)
+    {
+        std::cerr << "bench_banded_raster: " << fz_caught_message(ctx) << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// One full raster in bandCount bands; returns milliseconds
+double rasterize(RenderWorkerPool& pool, std::vector<fz_context*>& clones, fz_display_list* list,
+                 const fz_matrix& transform, const fz_irect& bbox, std::vector<unsigned char>& pixels, int bandCount,
+                 int serial)
+{
+    const int width = bbox.x1 - bbox.x0;
+    const int height = bbox.y1 - bbox.y0;
+    const int bandRows = (height + bandCount - 1) / bandCount;
+
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    int remaining = bandCount;
+    bool ok = true;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int band = 0; band < bandCount; ++band)
+    {
+        fz_irect bandBox = bbox;
+        bandBox.y0 = bbox.y0 + band * bandRows;
+        bandBox.y1 = std::min(bbox.y1, bandBox.y0 + bandRows);
+        unsigned char* rows = pixels.data() + static_cast<size_t>(band) * bandRows * width * 4;
+        auto job = [&, band, bandBox, rows]()
+        {
+            const bool bandOk = bandBox.y1 <= bandBox.y0 || drawBand(clones[band], list, transform, bandBox, rows);
+            std::lock_guard<std::mutex> lock(doneMutex);
+            ok = ok && bandOk;
+            --remaining;
+            doneCv.notify_one();
+        };
+
+        RenderWorkerPool::JobKey key;
+        key.kind = 1;
+        key.tileX = band;
+        key.tileY = serial;
+        if (bandCount == 1 || !pool.submit(RenderWorkerPool::Priority::Visible, key, job))
+        {
+            job();
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCv.wait(lock, [&remaining]()
+                    { return remaining == 0; });
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (!ok)
+    {
+        std::exit(1);
+    }
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const char* path = argc > 1 ? argv[1] : nullptr;
+    const int pageNumber = argc > 2 ? std::atoi(argv[2]) : 0;
+    const int targetWidth = argc > 3 ? std::atoi(argv[3]) : 1280;
+
+    fz_context* ctx = fz_new_context(nullptr, getSharedMuPdfLocks(), FZ_STORE_DEFAULT);
+    if (!ctx)
+    {
+        std::cerr << "bench_banded_raster: cannot create MuPDF context" << std::endl;
+        return 1;
+    }
+    fz_register_document_handlers(ctx);
+
+    fz_display_list* list = nullptr;
+    fz_document* doc = nullptr;
+    fz_var(list);
+    fz_var(doc);
+    fz_try(ctx)
+    {
+        if (path)
+        {
+            doc = fz_open_document(ctx, path);
+            list = fz_new_display_list_from_page_number(ctx, doc, pageNumber);
+        }
+        else
+        {
+            list = syntheticPage(ctx);
+        }
+    }
+    fz_catch(ctx)
+    {
+        std::cerr << "bench_banded_raster: " << fz_caught_message(ctx) << std::endl;
+        return 1;
+    }
+
+    const fz_rect bounds = fz_bound_display_list(ctx, list);
+    const float scale = static_cast<float>(targetWidth) / (bounds.x1 - bounds.x0);
+    const fz_matrix transform = fz_scale(scale, scale);
+    const fz_irect bbox = fz_round_rect(fz_transform_rect(bounds, transform));
+    const int width = bbox.x1 - bbox.x0;
+    const int height = bbox.y1 - bbox.y0;
+
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> bandCounts;
+    for (int bands = 1; bands <= static_cast<int>(cores) && bands <= 8; bands *= 2)
+    {
+        bandCounts.push_back(bands);
+    }
+    if (bandCounts.back() != static_cast<int>(std::min(cores, 8u)))
+    {
+        bandCounts.push_back(static_cast<int>(std::min(cores, 8u)));
+    }
+
+    RenderWorkerPool pool(bandCounts.back());
+    std::vector<fz_context*> clones;
+    clones.push_back(ctx);
+    for (int i = 1; i < bandCounts.back(); ++i)
+    {
+        clones.push_back(fz_clone_context(ctx));
+    }
+
+    std::cout << (path ? path : "synthetic vector page") << ", " << width << "x" << height << ", " << cores
+              << " core(s)" << std::endl;
+
+    const size_t bytes = static_cast<size_t>(width) * height * 4;
+    std::vector<unsigned char> reference(bytes);
+    std::vector<unsigned char> pixels(bytes);
+    int serial = 0;
+    double singleMs = 0.0;
+    bool identical = true;
+    for (int bands : bandCounts)
+    {
+        std::vector<double> times;
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            times.push_back(rasterize(pool, clones, list, transform, bbox, bands == 1 ? reference : pixels, bands,
+                                      ++serial));
+        }
+        std::sort(times.begin(), times.end());
+        const double median = times[times.size() / 2];
+        if (bands == 1)
+        {
+            singleMs = median;
+        }
+        const bool same = bands == 1 || std::memcmp(reference.data(), pixels.data(), bytes) == 0;
+        identical = identical && same;
+        std::cout << "  " << bands << (bands == 1 ? " band:  " : " bands: ") << median << " ms, "
+                  << singleMs / median << "x" << (same ? "" : "  OUTPUT DIFFERS") << std::endl;
+    }
+
+    pool.shutdown();
+    for (size_t i = 1; i < clones.size(); ++i)
+    {
+        fz_drop_context(clones[i]);
+    }
+    fz_drop_display_list(ctx, list);
+    fz_drop_document(ctx, doc);
+    fz_drop_context(ctx);
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+// Opens and closes documents through MuPdfContextPool many times over, the
+// way browse mode does, and checks that nothing accumulates: after the first
+// document every open reuses the same context, and the bytes its allocator
+// holds between documents stop growing once fonts and handlers are warm.
+//
+// Without arguments a generated reflowable book is cycled with a different
+// user stylesheet each time (as a relayout does). Pass document paths to
+// cycle those instead.
+
+#include "mupdf_context_pool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr int CYCLES = 50;
+constexpr int WARMUP_CYCLES = 5;                  // Fonts and lazily created tables settle first
+constexpr size_t RETAINED_SLACK_BYTES = 256 << 10; // Growth tolerated after warm-up
+constexpr float LAYOUT_WIDTH = 480;
+constexpr float LAYOUT_HEIGHT = 640;
+
+int g_failures = 0;
+
+void fail(int cycle, const char* what)
+{
+    if (++g_failures <= 20)
+    {
+        std::printf("FAIL cycle %d: %s\n", cycle, what);
+    }
+}
+
+std::string generatedBook()
+{
+    std::string html = "<html><head><title>Pool</title></head><body>";
+    for (int chapter = 1; chapter <= 8; ++chapter)
+    {
+        html += "<h1>Chapter " + std::to_string(chapter) + "</h1>";
+        for (int paragraph = 0; paragraph < 12; ++paragraph)
+        {
+            html += "<p><b>Lorem ipsum</b> dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+                    "incididunt ut labore et <i>dolore magna aliqua</i>. Ut enim ad minim veniam, quis nostrud "
+                    "exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.</p>";
+        }
+    }
+    html += "</body></html>";
+    return html;
+}
+
+// Open, lay out and interpret the first page, then close. False if MuPDF
+// threw; the context is released either way.
+bool cycleDocument(MuPdfContextPool& pool, int cycle, const char* path, const std::string& book)
+{
+    fz_context* ctx = pool.acquire();
+    if (!ctx)
+    {
+        fail(cycle, "pool returned no context");
+        return false;
+    }
+
+    const std::string css = "body { font-size: " + std::to_string(10 + cycle % 7) + "pt; }";
+    fz_buffer* buffer = nullptr;
+    fz_stream* stream = nullptr;
+    fz_document* doc = nullptr;
+    fz_display_list* list = nullptr;
+    fz_var(buffer);
+    fz_var(stream);
+    fz_var(doc);
+    fz_var(list);
+    bool ok = true;
+
+    fz_try(ctx)
+    {
+        fz_set_user_css(ctx, css.c_str());
+        if (path)
+        {
+            doc = fz_open_document(ctx, path);
+        }
+        else
+        {
+            buffer = fz_new_buffer_from_copied_data(ctx, reinterpret_cast<const unsigned char*>(book.data()),
+                                                     book.size());
+            stream = fz_open_buffer(ctx, buffer);
+            doc = fz_open_document_with_stream(ctx, "text/html", stream);
+        }
+        if (fz_is_document_reflowable(ctx, doc))
+        {
+            fz_layout_document(ctx, doc, LAYOUT_WIDTH, LAYOUT_HEIGHT, 12);
+        }
+        if (fz_count_pages(ctx, doc) > 0)
+        {
+            list = fz_new_display_list_from_page_number(ctx, doc, 0);
+        }
+    }
+    fz_always(ctx)
+    {
+        fz_drop_display_list(ctx, list);
+        fz_drop_document(ctx, doc);
+        fz_drop_stream(ctx, stream);
+        fz_drop_buffer(ctx, buffer);
+    }
+    fz_catch(ctx)
+    {
+        std::printf("MuPDF error: %s\n", fz_caught_message(ctx));
+        fail(cycle, "document did not open");
+        ok = false;
+    }
+
+    pool.release(ctx);
+    return ok;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    MuPdfContextPool& pool = MuPdfContextPool::shared();
+    const std::string book = generatedBook();
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        paths.push_back(argv[i]);
+    }
+
+    size_t warmBytes = 0;
+    size_t lastBytes = 0;
+    for (int cycle = 0; cycle < CYCLES; ++cycle)
+    {
+        const char* path = paths.empty() ? nullptr : paths[static_cast<size_t>(cycle) % paths.size()];
+        if (!cycleDocument(pool, cycle, path, book))
+        {
+            continue;
+        }
+
+        const MuPdfContextPool::Stats stats = pool.getStats();
+        if (stats.created != 1)
+        {
+            fail(cycle, "a closed document's context was not reused");
+        }
+        if (stats.idle != 1)
+        {
+            fail(cycle, "the released context is not idle");
+        }
+
+        const std::vector<MuPdfAllocator::Stats> allocators = pool.getAllocatorStats();
+        if (allocators.empty())
+        {
+            fail(cycle, "no allocator stats");
+            continue;
+        }
+        lastBytes = allocators.front().currentBytes;
+        if (cycle + 1 == WARMUP_CYCLES)
+        {
+            warmBytes = lastBytes;
+        }
+        else if (cycle + 1 > WARMUP_CYCLES && lastBytes > warmBytes + RETAINED_SLACK_BYTES)
+        {
+            char message[128];
+            std::snprintf(message, sizeof(message), "%zu KB retained after close, %zu KB after warm-up",
+                          lastBytes >> 10, warmBytes >> 10);
+            fail(cycle, message);
+        }
+    }
+
+    const MuPdfContextPool::Stats stats = pool.getStats();
+    std::printf("test_context_pool: %d cycles, %zu context(s) created, %llu reused, %zu KB retained (%zu KB after "
+                "warm-up)\n",
+                CYCLES, stats.created, static_cast<unsigned long long>(stats.reused), lastBytes >> 10,
+                warmBytes >> 10);
+    pool.logAllocatorStats();
+
+    if (g_failures > 0)
+    {
+        std::printf("test_context_pool: %d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Drives MemoryGovernor with made-up memory readings: budgets must follow the
+// free memory (clamped to the minimum and to each consumer's own maximum),
+// low memory must shed one consumer per poll in shrink order, polls must be
+// rate-limited, and the budgets must come back once the pressure is over.
+
+#include "memory_governor.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr uint64_t MB = 1ull << 20;
+
+// Mirrors memory_governor.cpp
+constexpr double USABLE_FRACTION = 0.5;
+constexpr size_t MIN_BUDGET_BYTES = 4 * MB;
+constexpr uint32_t POLL_INTERVAL_MS = 2000;
+constexpr uint32_t PRESSURE_POLL_INTERVAL_MS = 500;
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition && ++g_failures <= 20)
+    {
+        std::printf("FAIL %s\n", what.c_str());
+    }
+}
+
+struct Recorder
+{
+    std::vector<std::string> sheds;
+    std::vector<std::pair<std::string, size_t>> budgets;
+
+    size_t lastBudget(const std::string& name) const
+    {
+        for (auto it = budgets.rbegin(); it != budgets.rend(); ++it)
+        {
+            if (it->first == name)
+            {
+                return it->second;
+            }
+        }
+        return 0;
+    }
+};
+
+MemoryGovernor::Consumer consumer(Recorder& recorder, const char* name, int shrinkOrder, double share,
+                                  size_t maxBytes)
+{
+    MemoryGovernor::Consumer consumer;
+    consumer.name = name;
+    consumer.shrinkOrder = shrinkOrder;
+    consumer.share = share;
+    consumer.maxBytes = maxBytes;
+    consumer.usage = [] { return size_t{0}; };
+    consumer.setBudget = [&recorder, name](size_t bytes) { recorder.budgets.emplace_back(name, bytes); };
+    consumer.shed = [&recorder, name] { recorder.sheds.push_back(name); };
+    return consumer;
+}
+
+MemoryGovernor::Snapshot snapshot(uint64_t limitBytes, uint64_t availableBytes)
+{
+    MemoryGovernor::Snapshot memory;
+    memory.limitBytes = limitBytes;
+    memory.availableBytes = availableBytes;
+    memory.source = "test";
+    return memory;
+}
+
+std::string megabytes(size_t bytes)
+{
+    return std::to_string(static_cast<double>(bytes) / MB) + " MB";
+}
+} // namespace
+
+int main()
+{
+    MemoryGovernor& governor = MemoryGovernor::shared();
+    Recorder recorder;
+    MemoryGovernor::Snapshot memory = snapshot(0, 0);
+    governor.setMemorySource([&memory] { return memory; });
+
+    // Registered out of order on purpose; shedding follows shrinkOrder
+    governor.registerConsumer(consumer(recorder, "thumbnails", 2, 0.1, 0));
+    governor.registerConsumer(consumer(recorder, "store", 0, 0.0, 0));
+    governor.registerConsumer(consumer(recorder, "display lists", 3, 0.2, 0));
+    governor.registerConsumer(consumer(recorder, "pages", 1, 0.3, 16 * MB));
+
+    // No reading: consumers keep their defaults
+    governor.poll(0);
+    check(recorder.budgets.empty() && recorder.sheds.empty(), "unknown limit must leave the consumers alone");
+
+    // Plenty free: budgets are shares of half the free memory
+    memory = snapshot(1024 * MB, 400 * MB);
+    governor.poll(POLL_INTERVAL_MS);
+    const double usable = 400.0 * MB * USABLE_FRACTION;
+    check(recorder.lastBudget("pages") == 16 * MB,
+          "pages budget capped at its maximum, got " + megabytes(recorder.lastBudget("pages")));
+    check(recorder.lastBudget("thumbnails") == static_cast<size_t>(usable * 0.1),
+          "thumbnails budget, got " + megabytes(recorder.lastBudget("thumbnails")));
+    check(recorder.lastBudget("display lists") == static_cast<size_t>(usable * 0.2),
+          "display lists budget, got " + megabytes(recorder.lastBudget("display lists")));
+    check(recorder.lastBudget("store") == 0, "shed-only consumer must not get a budget");
+    check(recorder.sheds.empty(), "no shedding with memory to spare");
+    check(!governor.getStats().underPressure, "not under pressure with memory to spare");
+
+    // Within the poll interval nothing is re-read
+    const size_t budgetCalls = recorder.budgets.size();
+    memory = snapshot(64 * MB, 2 * MB);
+    governor.poll(POLL_INTERVAL_MS + POLL_INTERVAL_MS / 2);
+    check(recorder.budgets.size() == budgetCalls && recorder.sheds.empty(), "poll inside the interval must not act");
+
+    // Low limit: budgets drop to the minimum and the cheapest consumer sheds first
+    uint32_t now = 2 * POLL_INTERVAL_MS;
+    governor.poll(now);
+    check(recorder.lastBudget("pages") == MIN_BUDGET_BYTES,
+          "pages budget under pressure, got " + megabytes(recorder.lastBudget("pages")));
+    check(recorder.lastBudget("thumbnails") == MIN_BUDGET_BYTES,
+          "thumbnails budget under pressure, got " + megabytes(recorder.lastBudget("thumbnails")));
+    check(recorder.lastBudget("display lists") == MIN_BUDGET_BYTES,
+          "display lists budget under pressure, got " + megabytes(recorder.lastBudget("display lists")));
+    check(governor.getStats().underPressure, "2 MB free of 64 MB must be pressure");
+
+    // One more consumer per (faster) poll, then start over
+    for (int step = 0; step < 4; ++step)
+    {
+        now += PRESSURE_POLL_INTERVAL_MS;
+        governor.poll(now);
+    }
+    const std::vector<std::string> expected = {"store", "pages", "thumbnails", "display lists", "store"};
+    check(recorder.sheds == expected, "shed order store, pages, thumbnails, display lists, store");
+    const MemoryGovernor::Stats pressured = governor.getStats();
+    check(pressured.pressureEvents == 1, "one pressure event");
+    check(pressured.sheds == expected.size(), "shed count");
+
+    // Pressure over: no more shedding and the full budgets are handed out again
+    memory = snapshot(1024 * MB, 400 * MB);
+    now += PRESSURE_POLL_INTERVAL_MS;
+    governor.poll(now);
+    governor.poll(now + 1);
+    check(recorder.sheds.size() == expected.size(), "no shedding after the pressure is over");
+    check(!governor.getStats().underPressure, "pressure cleared");
+    check(recorder.lastBudget("pages") == 16 * MB,
+          "pages budget restored, got " + megabytes(recorder.lastBudget("pages")));
+    check(recorder.lastBudget("display lists") == static_cast<size_t>(usable * 0.2),
+          "display lists budget restored, got " + megabytes(recorder.lastBudget("display lists")));
+
+    governor.setMemorySource(nullptr);
+    if (g_failures > 0)
+    {
+        std::printf("test_memory_governor: %d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("test_memory_governor: %zu budget calls, %zu sheds as expected\n", recorder.budgets.size(),
+                recorder.sheds.size());
+    return 0;
+}
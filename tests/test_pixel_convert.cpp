@@ -0,0 +1,128 @@
+// Checks every vector pixel_convert kernel built for this target against the
+// scalar reference: all widths up to a few vector lengths (so every tail size
+// is covered), source and destination offsets that break vector alignment,
+// and guard words after the output that must stay untouched.
+
+#include "pixel_convert.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr size_t MAX_COUNT = 131;   // Several AVX2 iterations plus every tail length
+constexpr size_t MAX_OFFSET = 33;   // Byte offsets past a 32-byte boundary
+constexpr size_t GUARD = 64;        // Trailing bytes/words checked for overruns
+constexpr uint8_t GUARD_BYTE = 0xA5;
+constexpr uint32_t GUARD_WORD = 0xDEADBEEFu;
+
+int g_failures = 0;
+
+void fail(const char* isa, const char* kernel, size_t count, size_t offset, const char* what)
+{
+    if (++g_failures <= 20)
+    {
+        std::printf("FAIL %s %s: count %zu, offset %zu: %s\n", isa, kernel, count, offset, what);
+    }
+}
+
+void checkToArgb(const pixel_convert::Kernels& kernels, const char* name, size_t bytesPerPixel,
+                 void (*kernel)(const uint8_t*, uint32_t*, size_t),
+                 void (*reference)(const uint8_t*, uint32_t*, size_t), std::mt19937& random)
+{
+    const char* isa = pixel_convert::isaName(kernels.isa);
+    for (size_t count = 0; count <= MAX_COUNT; ++count)
+    {
+        for (size_t offset = 0; offset <= MAX_OFFSET; ++offset)
+        {
+            std::vector<uint8_t> src(offset + count * bytesPerPixel + GUARD);
+            for (uint8_t& byte : src)
+            {
+                byte = static_cast<uint8_t>(random());
+            }
+            // Destination words are offset too, as far as uint32_t alignment allows
+            const size_t dstOffset = offset % 8;
+            std::vector<uint32_t> expected(dstOffset + count + GUARD, GUARD_WORD);
+            std::vector<uint32_t> actual(dstOffset + count + GUARD, GUARD_WORD);
+
+            reference(src.data() + offset, expected.data() + dstOffset, count);
+            kernel(src.data() + offset, actual.data() + dstOffset, count);
+            if (actual != expected)
+            {
+                fail(isa, name, count, offset, "output differs from scalar or guard overwritten");
+            }
+        }
+    }
+}
+
+void checkArgbToRgb(const pixel_convert::Kernels& kernels, std::mt19937& random)
+{
+    const char* isa = pixel_convert::isaName(kernels.isa);
+    for (size_t count = 0; count <= MAX_COUNT; ++count)
+    {
+        for (size_t offset = 0; offset <= MAX_OFFSET; ++offset)
+        {
+            const size_t srcOffset = offset % 8;
+            std::vector<uint32_t> src(srcOffset + count + GUARD);
+            for (uint32_t& word : src)
+            {
+                word = static_cast<uint32_t>(random());
+            }
+            std::vector<uint8_t> expected(offset + count * 3 + GUARD, GUARD_BYTE);
+            std::vector<uint8_t> actual(offset + count * 3 + GUARD, GUARD_BYTE);
+
+            pixel_convert::scalar::argbToRgb(src.data() + srcOffset, expected.data() + offset, count);
+            kernels.argbToRgb(src.data() + srcOffset, actual.data() + offset, count);
+            if (actual != expected)
+            {
+                fail(isa, "argbToRgb", count, offset, "output differs from scalar or guard overwritten");
+            }
+        }
+    }
+}
+} // namespace
+
+int main()
+{
+    std::mt19937 random(12345);
+    int tested = 0;
+    for (pixel_convert::Isa isa : {pixel_convert::Isa::Sse2, pixel_convert::Isa::Avx2, pixel_convert::Isa::Neon})
+    {
+        pixel_convert::Kernels kernels;
+        if (!pixel_convert::kernelsFor(isa, kernels))
+        {
+            std::printf("skip %s: not available on this machine\n", pixel_convert::isaName(isa));
+            continue;
+        }
+        ++tested;
+        checkToArgb(kernels, "rgbaToArgb", 4, kernels.rgbaToArgb, pixel_convert::scalar::rgbaToArgb, random);
+        checkToArgb(kernels, "rgbToArgb", 3, kernels.rgbToArgb, pixel_convert::scalar::rgbToArgb, random);
+        checkArgbToRgb(kernels, random);
+        std::printf("%s kernels checked\n", pixel_convert::isaName(isa));
+    }
+
+    // The dispatching entry points use whichever set was selected
+    std::vector<uint8_t> rgba(MAX_COUNT * 4);
+    for (uint8_t& byte : rgba)
+    {
+        byte = static_cast<uint8_t>(random());
+    }
+    std::vector<uint32_t> expected(MAX_COUNT);
+    std::vector<uint32_t> actual(MAX_COUNT);
+    pixel_convert::scalar::rgbaToArgb(rgba.data(), expected.data(), MAX_COUNT);
+    pixel_convert::rgbaToArgb(rgba.data(), actual.data(), MAX_COUNT);
+    if (actual != expected)
+    {
+        fail(pixel_convert::isaName(pixel_convert::activeIsa()), "dispatch", MAX_COUNT, 0, "output differs");
+    }
+
+    if (g_failures > 0)
+    {
+        std::printf("test_pixel_convert: %d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("test_pixel_convert: %d vector kernel set(s) match scalar\n", tested);
+    return 0;
+}
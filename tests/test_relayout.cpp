@@ -0,0 +1,202 @@
+// Background relayout of a reflowable book through MuPdfDocument:
+// - cancelPrerendering(), which every page turn and zoom calls, must not drop
+//   a relayout that is still queued, or the new style never takes effect
+// - the page reported after the swap is the one on screen at swap time, not
+//   the one the relayout started from
+//
+// A small EPUB is generated in a temporary state directory, which also takes
+// the metadata sidecars and layout accelerators.
+
+#include "mupdf_document.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+constexpr int CANCEL_ROUNDS = 10;
+constexpr int CHAPTERS = 6;
+constexpr int SCALE = 100;
+constexpr auto RELAYOUT_TIMEOUT = std::chrono::seconds(20);
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition && ++g_failures <= 20)
+    {
+        std::printf("FAIL %s\n", what.c_str());
+    }
+}
+
+void addEntry(fz_context* ctx, fz_zip_writer* zip, const char* name, const std::string& text, int compress)
+{
+    fz_buffer* buffer =
+        fz_new_buffer_from_copied_data(ctx, reinterpret_cast<const unsigned char*>(text.data()), text.size());
+    fz_try(ctx)
+    {
+        fz_write_zip_entry(ctx, zip, name, buffer, compress);
+    }
+    fz_always(ctx)
+    {
+        fz_drop_buffer(ctx, buffer);
+    }
+    fz_catch(ctx)
+    {
+        fz_rethrow(ctx);
+    }
+}
+
+bool writeBook(const std::string& path)
+{
+    fz_context* ctx = fz_new_context(nullptr, nullptr, FZ_STORE_DEFAULT);
+    if (!ctx)
+    {
+        return false;
+    }
+
+    std::string manifest;
+    std::string spine;
+    fz_zip_writer* zip = nullptr;
+    fz_var(zip);
+    bool written = false;
+    fz_var(written);
+    fz_try(ctx)
+    {
+        zip = fz_new_zip_writer(ctx, path.c_str());
+        // The mimetype entry comes first and uncompressed
+        addEntry(ctx, zip, "mimetype", "application/epub+zip", 0);
+        addEntry(ctx, zip, "META-INF/container.xml",
+                 "<?xml version=\"1.0\"?><container version=\"1.0\" "
+                 "xmlns=\"urn:oasis:names:tc:opendocument:xmlns:container\"><rootfiles>"
+                 "<rootfile full-path=\"OEBPS/content.opf\" media-type=\"application/oebps-package+xml\"/>"
+                 "</rootfiles></container>",
+                 1);
+        for (int chapter = 1; chapter <= CHAPTERS; ++chapter)
+        {
+            const std::string id = "c" + std::to_string(chapter);
+            std::string html = "<?xml version=\"1.0\"?><html xmlns=\"http://www.w3.org/1999/xhtml\"><body><h1>Chapter " +
+                               std::to_string(chapter) + "</h1>";
+            for (int paragraph = 0; paragraph < 30; ++paragraph)
+            {
+                html += "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+                        "incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+                        "exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.</p>";
+            }
+            html += "</body></html>";
+            addEntry(ctx, zip, ("OEBPS/" + id + ".xhtml").c_str(), html, 1);
+            manifest += "<item id=\"" + id + "\" href=\"" + id + ".xhtml\" media-type=\"application/xhtml+xml\"/>";
+            spine += "<itemref idref=\"" + id + "\"/>";
+        }
+        addEntry(ctx, zip, "OEBPS/content.opf",
+                 "<?xml version=\"1.0\"?><package xmlns=\"http://www.idpf.org/2007/opf\" version=\"2.0\">"
+                 "<metadata xmlns:dc=\"http://purl.org/dc/elements/1.1/\"><dc:title>Relayout</dc:title></metadata>"
+                 "<manifest>" +
+                     manifest + "</manifest><spine>" + spine + "</spine></package>",
+                 1);
+        fz_close_zip_writer(ctx, zip);
+        written = true;
+    }
+    fz_always(ctx)
+    {
+        fz_drop_zip_writer(ctx, zip);
+    }
+    fz_catch(ctx)
+    {
+        std::printf("Cannot write %s: %s\n", path.c_str(), fz_caught_message(ctx));
+    }
+    fz_drop_context(ctx);
+    return written;
+}
+
+std::string fontCss(int points)
+{
+    return "body { font-size: " + std::to_string(points) + "pt; }";
+}
+
+// Poll as the main loop does; false if the relayout never finished
+bool waitForRelayout(MuPdfDocument& document, int currentPage, int& mappedPage)
+{
+    const auto deadline = std::chrono::steady_clock::now() + RELAYOUT_TIMEOUT;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (document.finishRelayout(currentPage, mappedPage))
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+} // namespace
+
+int main()
+{
+    const std::filesystem::path stateDir =
+        std::filesystem::temp_directory_path() / ("sdlreader-test-relayout-" + std::to_string(::getpid()));
+    std::filesystem::create_directories(stateDir);
+    setenv("SDL_READER_STATE_DIR", stateDir.string().c_str(), 1);
+    const std::string path = (stateDir / "relayout.epub").string();
+
+    if (!writeBook(path))
+    {
+        std::printf("test_relayout: cannot generate the test book\n");
+        return 1;
+    }
+
+    {
+        MuPdfDocument document;
+        check(document.open(path), "open the generated book");
+
+        // A page turn right after the style change usually lands while the
+        // relayout job is still queued
+        int page = 1;
+        for (int round = 0; round < CANCEL_ROUNDS; ++round)
+        {
+            const std::string css = fontCss(10 + round % 5);
+            if (!document.beginRelayout(css, page, SCALE))
+            {
+                check(false, "round " + std::to_string(round) + ": relayout did not start");
+                continue;
+            }
+            document.cancelPrerendering();
+
+            int mappedPage = -1;
+            const bool finished = waitForRelayout(document, page, mappedPage);
+            check(finished, "round " + std::to_string(round) + ": relayout cancelled by cancelPrerendering()");
+            check(!finished || (mappedPage >= 0 && mappedPage < document.getPageCount()),
+                  "round " + std::to_string(round) + ": mapped page " + std::to_string(mappedPage) + " out of range");
+            if (finished && mappedPage >= 0)
+            {
+                page = mappedPage;
+            }
+        }
+
+        // Same style again, so page numbers do not move: turning from page 1
+        // to 4 while the relayout runs must land on 4
+        const std::string css = fontCss(10 + (CANCEL_ROUNDS - 1) % 5);
+        check(document.beginRelayout(css, 1, SCALE), "relayout with the current style did not start");
+        int mappedPage = -1;
+        check(waitForRelayout(document, 4, mappedPage), "relayout with the current style never finished");
+        check(mappedPage == 4, "page turned during the relayout mapped to " + std::to_string(mappedPage) +
+                                   ", expected 4");
+        document.close();
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(stateDir, ec);
+
+    if (g_failures > 0)
+    {
+        std::printf("test_relayout: %d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("test_relayout: %d relayouts survived cancelPrerendering(), page turns mapped at swap time\n",
+                CANCEL_ROUNDS);
+    return 0;
+}